@@ -1,63 +1,385 @@
 #include <algorithm>
+#include <array>
+#include <barrier>
+#include <bit>
+#include <chrono>
+#include <cstddef>
 #include <fstream>
 #include <iostream>
-#include <map>
 #include <ostream>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-template <class Key, class Value>
-std::ostream& operator<<(std::ostream& os, const std::map<Key, Value>& map) {
-    os << "{";
-    for(const auto& pair : map){
-        os << "[" << pair.first << ": " << pair.second << "], ";
+using Stone = unsigned long long;
+
+// splitmix64 finalizer, stones are far from uniformly distributed
+std::size_t hash_stone(Stone stone) {
+  stone ^= stone >> 30;
+  stone *= 0xbf58476d1ce4e5b9ULL;
+  stone ^= stone >> 27;
+  stone *= 0x94d049bb133111ebULL;
+  stone ^= stone >> 31;
+  return static_cast<std::size_t>(stone);
+}
+
+/**
+ * Counts how often each stone appears. Open addressing with linear probing
+ * over flat arrays, so adding a stone never allocates unless the table has to
+ * grow. clear() only resets the slots that were used, which makes it cheap to
+ * reuse two counters and swap them between blinks.
+ */
+class StoneCounter {
+public:
+  explicit StoneCounter(std::size_t capacity = 1024) {
+    std::size_t slots = 16;
+    while (slots < 2 * capacity) {
+      slots *= 2;
+    }
+    resize(slots);
+  }
+
+  void add(Stone stone, unsigned long long amount) {
+    if (2 * (occupied_.size() + 1) > keys_.size()) {
+      grow();
     }
-    os << "}";
-    return os;
+    std::size_t idx = hash_stone(stone) & mask_;
+    while (used_[idx] && keys_[idx] != stone) {
+      idx = (idx + 1) & mask_;
+    }
+    if (!used_[idx]) {
+      used_[idx] = 1;
+      keys_[idx] = stone;
+      amounts_[idx] = 0;
+      occupied_.push_back(idx);
+    }
+    amounts_[idx] += amount;
+  }
+
+  void clear() {
+    for (const auto &idx : occupied_) {
+      used_[idx] = 0;
+    }
+    occupied_.clear();
+  }
+
+  std::size_t size() const { return occupied_.size(); }
+
+  template <class Func> void for_each(Func &&func) const {
+    for (const auto &idx : occupied_) {
+      func(keys_[idx], amounts_[idx]);
+    }
+  }
+
+private:
+  void resize(std::size_t slots) {
+    keys_.assign(slots, 0);
+    amounts_.assign(slots, 0);
+    used_.assign(slots, 0);
+    occupied_.clear();
+    occupied_.reserve(slots / 2);
+    mask_ = slots - 1;
+  }
+
+  void grow() {
+    std::vector<std::pair<Stone, unsigned long long>> entries{};
+    entries.reserve(occupied_.size());
+    for_each([&](Stone stone, unsigned long long amount) {
+      entries.push_back({stone, amount});
+    });
+    resize(2 * keys_.size());
+    for (const auto &[stone, amount] : entries) {
+      add(stone, amount);
+    }
+  }
+
+  std::vector<Stone> keys_{};
+  std::vector<unsigned long long> amounts_{};
+  std::vector<unsigned char> used_{};
+  std::vector<std::size_t> occupied_{};
+  std::size_t mask_ = 0;
+};
+
+std::ostream &operator<<(std::ostream &os, const StoneCounter &counter) {
+  os << "{";
+  counter.for_each([&](Stone stone, unsigned long long amount) {
+    os << "[" << stone << ": " << amount << "], ";
+  });
+  os << "}";
+  return os;
 }
 
-using Stone = unsigned long long;
+// 10^0 .. 10^19, every power of ten representable as a Stone
+constexpr std::array<Stone, 20> kPOWERS_OF_TEN = [] {
+  std::array<Stone, 20> powers{};
+  Stone power = 1;
+  for (auto &val : powers) {
+    val = power;
+    power *= 10;
+  }
+  return powers;
+}();
+
+// Estimate of floor(log10(stone)) by bit length, exact or one too large
+constexpr std::array<int, 65> kDIGITS_BY_BIT_LENGTH = [] {
+  std::array<int, 65> guesses{};
+  for (int bits = 0; bits < 65; ++bits) {
+    guesses[bits] = (bits * 1233) >> 12;
+  }
+  return guesses;
+}();
 
 int digits(const Stone stone) {
-    return std::to_string(stone).size();
+  if (stone == 0) {
+    return 1;
+  }
+  const int guess = kDIGITS_BY_BIT_LENGTH[std::bit_width(stone)];
+  return guess + 1 - (stone < kPOWERS_OF_TEN[guess] ? 1 : 0);
 }
 
-std::vector<Stone> blink(Stone stone){
-    if (stone == 0) {
-        return {1};
-    }
-    if (digits(stone) % 2 == 0){
-        auto as_string = std::to_string(stone);
-        std::vector<Stone> stones {};
-        stones.push_back(std::stoull(as_string.substr(0, as_string.size() / 2)));
-        stones.push_back(std::stoull(as_string.substr(as_string.size() / 2)));
-        return stones;
-    }
-    return {2024 * stone};
+// Writes the stones replacing `stone` into `out`, returns how many there are.
+int blink(Stone stone, std::array<Stone, 2> &out) {
+  if (stone == 0) {
+    out[0] = 1;
+    return 1;
+  }
+  const int num_digits = digits(stone);
+  if (num_digits % 2 == 0) {
+    const Stone half = kPOWERS_OF_TEN[num_digits / 2];
+    out[0] = stone / half;
+    out[1] = stone % half;
+    return 2;
+  }
+  out[0] = 2024 * stone;
+  return 1;
 }
 
-std::map<Stone, unsigned long long> blink(const std::map<Stone, unsigned long long>& map){
-    std::map<Stone, unsigned long long> blinked {};
-    for(const auto& pair : map){
-        auto blinked_stone = blink(pair.first);
-        for(const auto& stone : blinked_stone) {
-            blinked[stone] += pair.second;
-        }
+void blink(const StoneCounter &stones, StoneCounter &blinked) {
+  blinked.clear();
+  std::array<Stone, 2> children{};
+  stones.for_each([&](Stone stone, unsigned long long amount) {
+    int num_children = blink(stone, children);
+    for (int i = 0; i < num_children; ++i) {
+      blinked.add(children[i], amount);
     }
-    return blinked;
+  });
 }
 
-std::map<Stone, unsigned long long> blink(std::map<Stone, unsigned long long> map, unsigned int times){
-  for(int i = 0; i < times; ++i){
-    map = blink(map);
+StoneCounter blink(StoneCounter stones, unsigned int times) {
+  StoneCounter blinked{stones.size()};
+  for (unsigned int i = 0; i < times; ++i) {
+    blink(stones, blinked);
+    std::swap(stones, blinked);
   }
-  return map;
+  return stones;
 }
 
-unsigned long long total_stones(const std::map<Stone, unsigned long long>& map) {
-    unsigned long  long sum = 0;
-    std::ranges::for_each(map, [&](const auto& pair){sum += pair.second;});
+unsigned long long total_stones(const StoneCounter &stones) {
+  unsigned long long sum = 0;
+  stones.for_each([&](Stone, unsigned long long amount) { sum += amount; });
+  return sum;
+}
+
+/**
+ * Blinks a large stone population on several threads. Every thread owns one
+ * shard of the population, chosen by hash. A thread blinks the stones of its
+ * shard and routes each child into a buffer addressed to the shard the child
+ * belongs to. After a barrier every thread merges the buffers addressed to it
+ * into its shard of the next generation, so no counter is ever shared and no
+ * locks are needed.
+ */
+class ShardedBlinker {
+public:
+  ShardedBlinker(const StoneCounter &stones, unsigned int num_threads)
+      : num_threads_(num_threads),
+        shards_(num_threads, StoneCounter{stones.size() / num_threads}),
+        next_(num_threads, StoneCounter{stones.size() / num_threads}),
+        buffers_(num_threads * num_threads) {
+    stones.for_each([&](Stone stone, unsigned long long amount) {
+      shards_[shard_of(stone)].add(stone, amount);
+    });
+  }
+
+  void blink(unsigned int times) {
+    std::barrier sync{static_cast<std::ptrdiff_t>(num_threads_)};
+    auto work = [&](unsigned int thread) {
+      std::array<Stone, 2> children{};
+      for (unsigned int i = 0; i < times; ++i) {
+        for (unsigned int shard = 0; shard < num_threads_; ++shard) {
+          buffer(thread, shard).clear();
+        }
+        shards_[thread].for_each([&](Stone stone, unsigned long long amount) {
+          const int num_children = ::blink(stone, children);
+          for (int child = 0; child < num_children; ++child) {
+            buffer(thread, shard_of(children[child]))
+                .push_back({children[child], amount});
+          }
+        });
+        sync.arrive_and_wait();
+
+        next_[thread].clear();
+        for (unsigned int source = 0; source < num_threads_; ++source) {
+          for (const auto &[stone, amount] : buffer(source, thread)) {
+            next_[thread].add(stone, amount);
+          }
+        }
+        std::swap(shards_[thread], next_[thread]);
+        // Buffers addressed to this thread must be read before they are reused
+        sync.arrive_and_wait();
+      }
+    };
+
+    std::vector<std::jthread> threads{};
+    for (unsigned int thread = 1; thread < num_threads_; ++thread) {
+      threads.emplace_back(work, thread);
+    }
+    work(0);
+  }
+
+  std::size_t size() const {
+    std::size_t size = 0;
+    for (const auto &shard : shards_) {
+      size += shard.size();
+    }
+    return size;
+  }
+
+  unsigned long long total_stones() const {
+    unsigned long long sum = 0;
+    for (const auto &shard : shards_) {
+      sum += ::total_stones(shard);
+    }
     return sum;
+  }
+
+private:
+  // Uses the high bits, the counters index their tables with the low ones
+  unsigned int shard_of(Stone stone) const {
+    return (hash_stone(stone) >> 32) % num_threads_;
+  }
+
+  std::vector<std::pair<Stone, unsigned long long>> &
+  buffer(unsigned int source, unsigned int destination) {
+    return buffers_[source * num_threads_ + destination];
+  }
+
+  const unsigned int num_threads_;
+  std::vector<StoneCounter> shards_;
+  std::vector<StoneCounter> next_;
+  std::vector<std::vector<std::pair<Stone, unsigned long long>>> buffers_;
+};
+
+/**
+ * Memoizes how many stones a single stone turns into after a number of blinks.
+ * The table is kept across queries, so asking for 25 and then 75 blinks only
+ * computes the 50 additional levels, and a sweep over many depths costs about
+ * as much as the deepest one. It can be saved to disk and loaded again to
+ * serve stones shared between different inputs.
+ */
+class BlinkCache {
+public:
+  unsigned long long count(Stone stone, unsigned int times) {
+    if (times == 0) {
+      return 1;
+    }
+    const Key key{stone, times};
+    if (auto iter = memo_.find(key); iter != memo_.end()) {
+      return iter->second;
+    }
+    std::array<Stone, 2> children{};
+    const int num_children = blink(stone, children);
+    unsigned long long amount = 0;
+    for (int i = 0; i < num_children; ++i) {
+      amount += count(children[i], times - 1);
+    }
+    memo_.emplace(key, amount);
+    return amount;
+  }
+
+  unsigned long long count(const StoneCounter &stones, unsigned int times) {
+    unsigned long long sum = 0;
+    stones.for_each([&](Stone stone, unsigned long long amount) {
+      sum += amount * count(stone, times);
+    });
+    return sum;
+  }
+
+  std::size_t size() const { return memo_.size(); }
+
+  // One "stone times amount" triple per line
+  void save(std::string file_location) const {
+    std::ofstream output_file;
+    output_file.open(file_location);
+    if (!output_file.is_open()) {
+      throw std::invalid_argument("Unable to open file at " + file_location);
+    }
+    for (const auto &[key, amount] : memo_) {
+      output_file << key.stone << " " << key.times << " " << amount << "\n";
+    }
+  }
+
+  void load(std::string file_location) {
+    std::ifstream input_file;
+    input_file.open(file_location);
+    if (!input_file.is_open()) {
+      throw std::invalid_argument("Unable to open file at " + file_location);
+    }
+    Stone stone;
+    unsigned int times;
+    unsigned long long amount;
+    while (input_file >> stone >> times >> amount) {
+      memo_[{stone, times}] = amount;
+    }
+  }
+
+private:
+  struct Key {
+    Stone stone;
+    unsigned int times;
+
+    bool operator==(const Key &) const = default;
+  };
+
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      return std::hash<Stone>{}(key.stone * 0x9e3779b97f4a7c15ULL ^ key.times);
+    }
+  };
+
+  std::unordered_map<Key, unsigned long long, KeyHash> memo_{};
+};
+
+// Times the blink loop. Stone amounts overflow long before 1000 blinks, only
+// the runtime is of interest here.
+void benchmark_blinks(const StoneCounter &stones, unsigned int times) {
+  auto start = std::chrono::steady_clock::now();
+  StoneCounter blinked = blink(stones, times);
+  auto end = std::chrono::steady_clock::now();
+  std::cout << times << " blinks: "
+            << std::chrono::duration<double, std::milli>(end - start).count()
+            << " ms (" << blinked.size() << " distinct stones)\n";
+}
+
+void benchmark_sharded_blinks(const StoneCounter &stones, unsigned int times) {
+  double single_thread_ms = 0;
+  for (unsigned int num_threads : {1, 2, 4, 8, 16}) {
+    ShardedBlinker blinker{stones, num_threads};
+    auto start = std::chrono::steady_clock::now();
+    blinker.blink(times);
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (num_threads == 1) {
+      single_thread_ms = ms;
+    }
+    std::cout << num_threads << " threads, " << times << " blinks: " << ms
+              << " ms (speedup " << single_thread_ms / ms << ", "
+              << blinker.size() << " distinct stones, "
+              << blinker.total_stones() << " stones)\n";
+  }
 }
 
 int main(int argc, char **argv) {
@@ -87,13 +409,73 @@ int main(int argc, char **argv) {
     initial_stones.push_back(stone);
     idx += read_chars;
   }
-  std::map<Stone, unsigned long long> stone_to_amount {};
-  std::ranges::for_each(initial_stones, [&](const auto& val){stone_to_amount[val]++;});
+  StoneCounter stone_to_amount {initial_stones.size()};
+  std::ranges::for_each(initial_stones, [&](const auto& val){stone_to_amount.add(val, 1);});
 
   
+  // Optional arguments:
+  //   bench [blinks]  time the generation-by-generation blink loop, 1000
+  //                   blinks if bench is the last argument
+  //   cache <file>    load the blink cache from and save it to <file>
+  //   sweep <blinks>  print the number of stones for every depth up to <blinks>
+  //   pbench <blinks> time the sharded blink loop on 1 to 16 threads
+  //   random <count>  add <count> pseudo-random stones, to get large populations
+  unsigned int bench_blinks = 0, sweep_blinks = 0, pbench_blinks = 0;
+  std::size_t random_stones = 0;
+  std::string cache_file = "";
+  for (int arg = 2; arg < argc; arg += 2) {
+    const std::string option = argv[arg];
+    if (arg + 1 == argc) {
+      if (option == "bench") {
+        bench_blinks = 1000;
+      } else {
+        std::cout << "Missing value for option " << option << "\n";
+      }
+    } else if (option == "bench") {
+      bench_blinks = std::stoul(argv[arg + 1]);
+    } else if (option == "cache") {
+      cache_file = argv[arg + 1];
+    } else if (option == "sweep") {
+      sweep_blinks = std::stoul(argv[arg + 1]);
+    } else if (option == "pbench") {
+      pbench_blinks = std::stoul(argv[arg + 1]);
+    } else if (option == "random") {
+      random_stones = std::stoull(argv[arg + 1]);
+    }
+  }
+
+  std::mt19937_64 generator{2024};
+  std::uniform_int_distribution<Stone> distribution{0, 999999999999};
+  for (std::size_t i = 0; i < random_stones; ++i) {
+    stone_to_amount.add(distribution(generator), 1);
+  }
+
+  BlinkCache cache{};
+  if (cache_file != "" && std::ifstream(cache_file).good()) {
+    cache.load(cache_file);
+  }
+
   // Task 1
-  std::cout << "Size after " << 25 <<" blinks: " << total_stones(blink(stone_to_amount, 25)) << "\n";
+  std::cout << "Size after " << 25 <<" blinks: " << cache.count(stone_to_amount, 25) << "\n";
 
   // Task 2
-  std::cout << "Size after " << 75 <<" blinks: " << total_stones(blink(stone_to_amount, 75)) << "\n";
+  std::cout << "Size after " << 75 <<" blinks: " << cache.count(stone_to_amount, 75) << "\n";
+
+  // Amounts overflow after a few hundred blinks and wrap around
+  for (unsigned int times = 1; times <= sweep_blinks; ++times) {
+    std::cout << "Size after " << times << " blinks: "
+              << cache.count(stone_to_amount, times) << "\n";
+  }
+
+  if (bench_blinks > 0) {
+    benchmark_blinks(stone_to_amount, bench_blinks);
+  }
+
+  if (pbench_blinks > 0) {
+    benchmark_sharded_blinks(stone_to_amount, pbench_blinks);
+  }
+
+  if (cache_file != "") {
+    cache.save(cache_file);
+  }
 }
\ No newline at end of file
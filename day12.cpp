@@ -1,247 +1,205 @@
 #include <algorithm>
+#include <array>
 #include <cstddef>
-#include <deque>
 #include <iostream>
-#include <map>
-#include <ostream>
-#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "array2d.h"
-#include "vector.h"
 
 using Farm = array2D::Array2D<char>;
 
-template <class T>
-std::ostream &operator<<(std::ostream &os, const std::set<T> &set) {
-  os << "[";
-  std::ranges::for_each(set, [&](const auto &val) { os << val << ", "; });
-  os << "]";
-  return os;
+// ===== Regions =====
+struct Regions {
+  // Label of the region every plot belongs to, labels are 0 .. areas.size()
+  array2D::Array2D<int> labels;
+  std::vector<int> areas;
+};
+
+int find_root(std::vector<int> &parents, int label) {
+  while (parents[label] != label) {
+    parents[label] = parents[parents[label]];
+    label = parents[label];
+  }
+  return label;
 }
 
-// ===== Task 1 =====
-using Region = std::set<vector::Vector>;
-
-
-Region get_region(vector::Vector start, const Farm &farm) {
-  std::deque<vector::Vector> queue{start};
-  Region region{};
-  const char plant = farm.cat(start.x, start.y);
-  while (!queue.empty()) {
-    vector::Vector current = queue.back();
-    queue.pop_back();
+/**
+ * Connected-component labelling in one raster scan. Every plot joins the
+ * region of its left and upper neighbor if they grow the same plant, a
+ * union-find over the provisional labels merges regions that meet. A second
+ * pass over the label grid replaces provisional labels by compact final ones
+ * and counts the area of each region.
+ */
+Regions label_regions(const Farm &farm) {
+  array2D::Array2D<int> labels{farm.length(), farm.height(), 0};
+  std::vector<int> parents{};
+  parents.reserve(farm.length() * farm.height());
 
-    // Is plot correct plant type?
-    if (farm.cat(current.x, current.y) != plant) {
-      continue;
-    }
-    // Plot already in region?
-    if (region.contains(current)) {
-      continue;
+  for (std::size_t y = 0; y < farm.height(); ++y) {
+    for (std::size_t x = 0; x < farm.length(); ++x) {
+      const char plant = farm.cat(x, y);
+      const bool same_as_left = x > 0 && farm.cat(x - 1, y) == plant;
+      const bool same_as_up = y > 0 && farm.cat(x, y - 1) == plant;
+
+      int label;
+      if (same_as_left && same_as_up) {
+        label = find_root(parents, labels.cat(x - 1, y));
+        int other = find_root(parents, labels.cat(x, y - 1));
+        if (label != other) {
+          parents[std::max(label, other)] = std::min(label, other);
+          label = std::min(label, other);
+        }
+      } else if (same_as_left) {
+        label = labels.cat(x - 1, y);
+      } else if (same_as_up) {
+        label = labels.cat(x, y - 1);
+      } else {
+        label = parents.size();
+        parents.push_back(label);
+      }
+      labels.at(x, y) = label;
     }
+  }
 
-    region.insert(current);
-    // Queue neighbors
-    if (current.y + 1 < farm.height()) {
-      queue.push_back({current.x, current.y + 1});
-    }
-    if (current.y > 0) {
-      queue.push_back({current.x, current.y - 1});
-    }
-    if (current.x + 1 < farm.height()) {
-      queue.push_back({current.x + 1, current.y});
-    }
-    if (current.x > 0) {
-      queue.push_back({current.x - 1, current.y});
+  std::vector<int> final_labels(parents.size(), -1);
+  std::vector<int> areas{};
+  for (std::size_t y = 0; y < farm.height(); ++y) {
+    for (std::size_t x = 0; x < farm.length(); ++x) {
+      int root = find_root(parents, labels.cat(x, y));
+      if (final_labels[root] == -1) {
+        final_labels[root] = areas.size();
+        areas.push_back(0);
+      }
+      labels.at(x, y) = final_labels[root];
+      ++areas[final_labels[root]];
     }
   }
-  return region;
+  return {labels, areas};
 }
 
-int calculate_circumference(const Region &region) {
-  int circumference = 4 * region.size();
-  for (const auto &plot : region) {
-    if (plot.x > 0 && region.contains({plot.x - 1, plot.y})) {
-      --circumference;
+// ===== Fences =====
+struct Fences {
+  // Indexed by region label
+  std::vector<int> circumferences;
+  std::vector<int> sides;
+};
+
+/**
+ * Slides a 2x2 window over the label grid, including windows hanging over the
+ * border (outside plots have label -1), for the window rows [first_row,
+ * last_row). The top and left pair of each window are checked for a fence
+ * between them, so every fence is counted exactly once. A region has as many
+ * sides as corners, and the corners of a region inside a window follow from
+ * how many of the four plots it covers: one or three plots form one corner,
+ * two diagonal plots form two.
+ */
+void count_fences(const array2D::Array2D<int> &labels, int first_row,
+                  int last_row, Fences &fences) {
+  const int length = labels.length(), height = labels.height();
+  auto label_at = [&](int x, int y) {
+    if (x < 0 || y < 0 || x >= length || y >= height) {
+      return -1;
     }
-    if (region.contains({plot.x + 1, plot.y})) {
-      --circumference;
+    return labels.cat(x, y);
+  };
+
+  for (int y = first_row; y < last_row; ++y) {
+    for (int x = -1; x < length; ++x) {
+      // Top left, top right, bottom left, bottom right
+      const std::array<int, 4> window{label_at(x, y), label_at(x + 1, y),
+                                      label_at(x, y + 1),
+                                      label_at(x + 1, y + 1)};
+      if (window[0] != window[1]) {
+        if (window[0] != -1) {
+          ++fences.circumferences[window[0]];
+        }
+        if (window[1] != -1) {
+          ++fences.circumferences[window[1]];
+        }
+      }
+      if (window[0] != window[2]) {
+        if (window[0] != -1) {
+          ++fences.circumferences[window[0]];
+        }
+        if (window[2] != -1) {
+          ++fences.circumferences[window[2]];
+        }
+      }
+
+      for (int i = 0; i < 4; ++i) {
+        const int label = window[i];
+        if (label == -1 || std::find(window.begin(), window.begin() + i,
+                                     label) != window.begin() + i) {
+          continue;
+        }
+        const int covered = std::ranges::count(window, label);
+        if (covered == 1 || covered == 3) {
+          ++fences.sides[label];
+        } else if (covered == 2 &&
+                   ((window[0] == label && window[3] == label) ||
+                    (window[1] == label && window[2] == label))) {
+          fences.sides[label] += 2;
+        }
+      }
     }
-    if (plot.y > 0 && region.contains({plot.x, plot.y - 1})) {
-      --circumference;
+  }
+}
+
+/**
+ * Counts fences of all regions at once. With several threads every thread
+ * takes a band of window rows and counts into its own Fences, which are summed
+ * up at the end.
+ */
+Fences count_fences(const Regions &regions, unsigned int num_threads = 1) {
+  const std::size_t num_labels = regions.areas.size();
+  const int first_row = -1, last_row = regions.labels.height();
+  const int band = (last_row - first_row + num_threads - 1) / num_threads;
+
+  std::vector<Fences> per_thread(
+      num_threads, {std::vector<int>(num_labels, 0),
+                    std::vector<int>(num_labels, 0)});
+  {
+    std::vector<std::jthread> threads{};
+    for (unsigned int thread = 0; thread < num_threads; ++thread) {
+      const int from = first_row + thread * band;
+      const int to = std::min(from + band, last_row);
+      threads.emplace_back([&, from, to, thread] {
+        count_fences(regions.labels, from, to, per_thread[thread]);
+      });
     }
-    if (region.contains({plot.x, plot.y + 1})) {
-      --circumference;
+  }
+
+  Fences fences = per_thread[0];
+  for (unsigned int thread = 1; thread < num_threads; ++thread) {
+    for (std::size_t label = 0; label < num_labels; ++label) {
+      fences.circumferences[label] += per_thread[thread].circumferences[label];
+      fences.sides[label] += per_thread[thread].sides[label];
     }
   }
-  return circumference;
+  return fences;
 }
 
-int get_cost_of_fences(const Farm &farm) {
+// ===== Task 1 =====
+int get_cost_of_fences(const Regions &regions, const Fences &fences) {
   int sum = 0;
-  array2D::Array2D<int> is_in_region{farm.length(), farm.height(), 0};
-  for (int y = 0; y < farm.height(); ++y) {
-    for (int x = 0; x < farm.length(); ++x) {
-      if (is_in_region.at(x, y) == 0) {
-        Region region = get_region({x, y}, farm);
-        std::ranges::for_each(region, [&](const auto &val) {
-          is_in_region.at(val.x, val.y) = 1;
-        });
-        int area = region.size();
-        int circumference = calculate_circumference(region);
-        sum += area * circumference;
-      }
-    }
+  for (std::size_t label = 0; label < regions.areas.size(); ++label) {
+    sum += regions.areas[label] * fences.circumferences[label];
   }
   return sum;
 }
 
 // ===== Task 2 =====
-int calculate_sides(const Region& region){
-    // for each side of each point, track if it is part of an already calculate side
-    // if it is in a side at all
-    // UP, RIGHT, DOWN, LEFT
-    const int UP = 0, RIGHT = 1, DOWN = 2, LEFT = 3;
-    std::map<vector::Vector, std::array<bool, 4>> is_in_side;
-    std::ranges::for_each(region, [&](const auto& val){is_in_side[val] = {false, false, false, false};});
-    
-    int sides = 0;
-    for (const auto& point : region) {
-        // UP ( y - 1)
-        if(!region.contains({point.x, point.y - 1}) && !is_in_side[point][UP]) {
-            ++sides;
-
-            // Mark side;
-            is_in_side[point][UP] = true;
-            // Check right
-            int offset = 1;
-            vector::Vector offset_point {point.x + offset, point.y }, offset_adjacent_point {point.x + offset, point.y - 1};
-            while(region.contains(offset_point) && !region.contains(offset_adjacent_point)) {
-                is_in_side[offset_point][UP] = true;
-                ++offset;
-                offset_point = {point.x + offset, point.y };
-                offset_adjacent_point = {point.x + offset, point.y - 1};
-            }
-            // Check left
-            offset = -1;
-            offset_point = {point.x + offset, point.y };
-            offset_adjacent_point = {point.x + offset, point.y - 1};
-            while(region.contains(offset_point) && !region.contains(offset_adjacent_point)) {
-                is_in_side[offset_point][UP] = true;
-                --offset;
-                offset_point = {point.x + offset, point.y };
-                offset_adjacent_point = {point.x + offset, point.y - 1};
-            }
-        }
-
-
-        // DOWN ( y + 1)
-        if(!region.contains({point.x, point.y + 1}) && !is_in_side[point][DOWN]) {
-            ++sides;
-
-            // Mark side;
-            is_in_side[point][DOWN] = true;
-            // Check right
-            int offset = 1;
-            vector::Vector offset_point {point.x + offset, point.y }, offset_adjacent_point {point.x + offset, point.y + 1};
-            while(region.contains(offset_point) && !region.contains(offset_adjacent_point)) {
-                is_in_side[offset_point][DOWN] = true;
-                ++offset;
-                offset_point = {point.x + offset, point.y };
-                offset_adjacent_point = {point.x + offset, point.y + 1};
-            }
-            // Check left
-            offset = -1;
-            offset_point = {point.x + offset, point.y };
-            offset_adjacent_point = {point.x + offset, point.y - 1};
-            while(region.contains(offset_point) && !region.contains(offset_adjacent_point)) {
-                is_in_side[offset_point][DOWN] = true;
-                --offset;
-                offset_point = {point.x + offset, point.y };
-                offset_adjacent_point = {point.x + offset, point.y - 1};
-            }
-        }
-
-        // RIGHT ( x + 1)
-        if(!region.contains({point.x + 1, point.y}) && !is_in_side[point][RIGHT]) {
-            ++sides;
-
-            // Mark side;
-            is_in_side[point][RIGHT] = true;
-            // Check down
-            int offset = 1;
-            vector::Vector offset_point {point.x , point.y + offset }, offset_adjacent_point {point.x + 1, point.y + offset};
-            while(region.contains(offset_point) && !region.contains(offset_adjacent_point)) {
-                is_in_side[offset_point][RIGHT] = true;
-                ++offset;
-                offset_point = {point.x , point.y + offset};
-                offset_adjacent_point = {point.x + 1, point.y + offset};
-            }
-            // Check up
-            offset = -1;
-            offset_point = {point.x, point.y + offset };
-            offset_adjacent_point = {point.x + 1, point.y + offset};
-            while(region.contains(offset_point) && !region.contains(offset_adjacent_point)) {
-                is_in_side[offset_point][RIGHT] = true;
-                --offset;
-                offset_point = {point.x, point.y + offset};
-                offset_adjacent_point = {point.x + 1, point.y + offset};
-            }
-        }
-
-
-        // LEFT ( x - 1)
-        if(!region.contains({point.x - 1, point.y}) && !is_in_side[point][LEFT]) {
-            ++sides;
-
-            // Mark side;
-            is_in_side[point][LEFT] = true;
-            // Check down
-            int offset = 1;
-            vector::Vector offset_point {point.x , point.y + offset }, offset_adjacent_point {point.x - 1, point.y + offset};
-            while(region.contains(offset_point) && !region.contains(offset_adjacent_point)) {
-                is_in_side[offset_point][LEFT] = true;
-                ++offset;
-                offset_point = {point.x , point.y + offset};
-                offset_adjacent_point = {point.x - 1, point.y + offset};
-            }
-            // Check up
-            offset = -1;
-            offset_point = {point.x, point.y + offset };
-            offset_adjacent_point = {point.x - 1, point.y + offset};
-            while(region.contains(offset_point) && !region.contains(offset_adjacent_point)) {
-                is_in_side[offset_point][LEFT] = true;
-                --offset;
-                offset_point = {point.x, point.y + offset};
-                offset_adjacent_point = {point.x - 1, point.y + offset};
-            }
-        }
-    }
-    return sides;
-}
-
-int get_cost_of_fences_with_bulk_discount(const Farm &farm) {
+int get_cost_of_fences_with_bulk_discount(const Regions &regions,
+                                          const Fences &fences) {
   int sum = 0;
-  array2D::Array2D<int> is_in_region{farm.length(), farm.height(), 0};
-  for (std::size_t y = 0; y < farm.height(); ++y) {
-    for (std::size_t x = 0; x < farm.length(); ++x) {
-      if (is_in_region.at(x, y) == 0) {
-        Region region = get_region({static_cast<int>(x), static_cast<int>(y)}, farm);
-        std::ranges::for_each(region, [&](const auto &val) {
-          is_in_region.at(val.x, val.y) = 1;
-        });
-        int area = region.size();
-        int sides = calculate_sides(region);
-        //std::cout << region << " | Char: " << farm.at(region.begin()->x, region.begin()->y) << " | Size: " << area << " | Sides: " << sides << "\n";
-        sum += area * sides;
-      }
-    }
+  for (std::size_t label = 0; label < regions.areas.size(); ++label) {
+    sum += regions.areas[label] * fences.sides[label];
   }
   return sum;
 }
 
-
 int main(int argc, char **argv) {
   if (argc < 2) {
     std::cout << "Not enough arguments! " << "\n";
@@ -252,10 +210,16 @@ int main(int argc, char **argv) {
   Farm farm = array2D::read_array<char>(argv[1], [](char c){return c;});
   // Farm farm = read_input(argv[1]);
 
+  // Optional second argument is the number of threads counting fences
+  unsigned int num_threads =
+      argc > 2 ? std::max(1UL, std::stoul(argv[2])) : 1;
+  const Regions regions = label_regions(farm);
+  const Fences fences = count_fences(regions, num_threads);
+
   // Task 1 : Correctly ordered pages
-  int cost_of_fences = get_cost_of_fences(farm);
+  int cost_of_fences = get_cost_of_fences(regions, fences);
   std::cout << "Cost of fences: " << cost_of_fences << "\n";
   // Task 2 :
-  int cost_of_fences_with_bulk_discount = get_cost_of_fences_with_bulk_discount(farm);
+  int cost_of_fences_with_bulk_discount = get_cost_of_fences_with_bulk_discount(regions, fences);
   std::cout << "Cost of fences with bulk discount: " << cost_of_fences_with_bulk_discount << "\n";
 }
\ No newline at end of file
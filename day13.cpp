@@ -1,11 +1,15 @@
 #include <algorithm>
-#include <cmath>
+#include <array>
+#include <climits>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "linear_system.h"
+
 struct Equation {
   long long x, y, z;
 
@@ -48,50 +52,178 @@ std::vector<EquationSet> read_input(std::string file_location) {
   return equations;
 }
 
+enum class Solution : int { Solved, NoSolution, Overflow, Dependent };
+
+/**
+ * Solves x1 * a + y1 * b = z1, x2 * a + y2 * b = z2 exactly with Cramer's
+ * rule on 128 bit intermediates. Presses have to be non-negative integers, 3
+ * tokens for A and 1 for B. Linearly dependent machines are solved for the
+ * cheapest combination of presses; Dependent is only reported if that search
+ * is impossible (a button moving the claw backwards). Presses or tokens beyond
+ * long long are reported as Overflow.
+ */
+Solution solve_tokens(long long x1, long long y1, long long z1, long long x2,
+                      long long y2, long long z2, long long &tokens) {
+  std::array<linear::Integer, 2> presses{};
+  try {
+    switch (linear::solve_unique<2>({{{x1, y1}, {x2, y2}}}, {z1, z2}, presses)) {
+    case linear::Status::Unique:
+      break;
+    case linear::Status::NoIntegerSolution:
+      return Solution::NoSolution;
+    case linear::Status::Singular: {
+      auto cheapest =
+          linear::solve_min_cost({{{x1, y1}, {x2, y2}}, {z1, z2}}, {3, 1});
+      if (!cheapest) {
+        return Solution::NoSolution;
+      }
+      std::ranges::copy(*cheapest, presses.begin());
+      break;
+    }
+    }
+  } catch (const std::overflow_error &) {
+    return Solution::Overflow;
+  } catch (const std::invalid_argument &) {
+    return Solution::Dependent;
+  }
+
+  const auto [a, b] = presses;
+  if (a < 0 || b < 0) {
+    return Solution::NoSolution;
+  }
+  const __int128 total = 3 * (__int128)a + b;
+  if (total > LLONG_MAX) {
+    return Solution::Overflow;
+  }
+  tokens = static_cast<long long>(total);
+  return Solution::Solved;
+}
+
 long long get_required_tokens(const EquationSet &equation_set) {
   const auto &eq1 = equation_set.eq1;
   const auto &eq2 = equation_set.eq2;
-  long long numerator = (eq1.x * eq2.z - eq2.y * eq1.z);
-  long long denominator = (eq1.y * eq2.x - eq1.x * eq2.y);
-  if (denominator == 0) {
+  long long tokens = 0;
+  switch (solve_tokens(eq1.x, eq1.y, eq1.z, eq2.x, eq2.y, eq2.z, tokens)) {
+  case Solution::Solved:
+    return tokens;
+  case Solution::NoSolution:
+    return 0;
+  case Solution::Overflow:
+    throw std::overflow_error("Required tokens do not fit into long long!");
+  case Solution::Dependent:
     std::cerr << "Equation is linearly dependent!" << "\n";
     throw std::logic_error("Equations linearly dependant!");
   }
-  double a_double = ((double)(eq1.y * eq2.z - eq2.y * eq1.z)) /
-                    (eq1.y * eq2.x - eq1.x * eq2.y);
-  long long a = std::round(a_double);
-  if (a_double - a != 0) {
-    return 0;
+  return 0;
+}
+
+// ===== Batches =====
+// Structure of arrays over many EquationSets, keeps the solver loop streaming
+struct EquationBatch {
+  std::vector<long long> x1, y1, z1, x2, y2, z2;
+
+  EquationBatch(const std::vector<EquationSet> &equations,
+                long long prize_offset = 0) {
+    for (auto *column : {&x1, &y1, &z1, &x2, &y2, &z2}) {
+      column->reserve(equations.size());
+    }
+    for (const auto &set : equations) {
+      x1.push_back(set.eq1.x);
+      y1.push_back(set.eq1.y);
+      z1.push_back(set.eq1.z + prize_offset);
+      x2.push_back(set.eq2.x);
+      y2.push_back(set.eq2.y);
+      z2.push_back(set.eq2.z + prize_offset);
+    }
   }
 
-  double b_double = ((double)eq1.z - eq1.x * a) / eq1.y;
-  long long b = std::round(b_double);
-  if (b_double - b != 0) {
-    return 0;
+  std::size_t size() const { return x1.size(); }
+};
+
+struct BatchTokens {
+  long long tokens = 0;
+  // Machines whose tokens (or whose contribution to the sum) overflowed
+  std::size_t overflows = 0;
+  std::size_t dependent = 0;
+};
+
+BatchTokens get_total_tokens(const EquationBatch &batch, std::size_t from,
+                             std::size_t to) {
+  BatchTokens result{};
+  for (std::size_t i = from; i < to; ++i) {
+    long long tokens = 0;
+    switch (solve_tokens(batch.x1[i], batch.y1[i], batch.z1[i], batch.x2[i],
+                         batch.y2[i], batch.z2[i], tokens)) {
+    case Solution::Solved:
+      if (__builtin_add_overflow(result.tokens, tokens, &result.tokens)) {
+        ++result.overflows;
+      }
+      break;
+    case Solution::NoSolution:
+      break;
+    case Solution::Overflow:
+      ++result.overflows;
+      break;
+    case Solution::Dependent:
+      ++result.dependent;
+      break;
+    }
   }
-  return a * 3 + b;
+  return result;
 }
 
-// ===== Task 1 =====
-long long get_total_tokens(const std::vector<EquationSet> &equations) {
-  long long sum = 0;
-  for (const auto &eq : equations) {
-    sum += get_required_tokens(eq);
+// Splits the batch into one contiguous chunk per thread
+BatchTokens get_total_tokens(const EquationBatch &batch,
+                             unsigned int num_threads) {
+  std::vector<BatchTokens> per_thread(num_threads);
+  const std::size_t chunk = (batch.size() + num_threads - 1) / num_threads;
+  {
+    std::vector<std::jthread> threads{};
+    for (unsigned int thread = 0; thread < num_threads; ++thread) {
+      const std::size_t from = std::min(batch.size(), thread * chunk);
+      const std::size_t to = std::min(batch.size(), from + chunk);
+      threads.emplace_back([&, from, to, thread] {
+        per_thread[thread] = get_total_tokens(batch, from, to);
+      });
+    }
+  }
+
+  BatchTokens result{};
+  for (const auto &partial : per_thread) {
+    if (__builtin_add_overflow(result.tokens, partial.tokens, &result.tokens)) {
+      ++result.overflows;
+    }
+    result.overflows += partial.overflows;
+    result.dependent += partial.dependent;
   }
-  return sum;
+  return result;
 }
 
-// ===== Task 2 =====
-long long get_total_tokens_with_error(std::vector<EquationSet> equations) {
-  std::ranges::for_each(equations, [](auto &set) {
-    set.eq1.z += 10000000000000;
-    set.eq2.z += 10000000000000;
-  });
-  long long sum = 0;
-  for (const auto &eq : equations) {
-    sum += get_required_tokens(eq);
+long long checked_total(const BatchTokens &result) {
+  if (result.overflows > 0) {
+    throw std::overflow_error(std::to_string(result.overflows) +
+                              " machines overflowed the token count!");
+  }
+  if (result.dependent > 0) {
+    std::cerr << result.dependent << " equations are linearly dependent!"
+              << "\n";
+    throw std::logic_error("Equations linearly dependant!");
   }
-  return sum;
+  return result.tokens;
+}
+
+// ===== Task 1 =====
+long long get_total_tokens(const std::vector<EquationSet> &equations,
+                           unsigned int num_threads = 1) {
+  return checked_total(
+      get_total_tokens(EquationBatch(equations), num_threads));
+}
+
+// ===== Task 2 =====
+long long get_total_tokens_with_error(const std::vector<EquationSet> &equations,
+                                      unsigned int num_threads = 1) {
+  return checked_total(get_total_tokens(
+      EquationBatch(equations, 10000000000000), num_threads));
 }
 
 int main(int argc, char **argv) {
@@ -102,14 +234,17 @@ int main(int argc, char **argv) {
 
   // First argument is input file location
   const std::vector<EquationSet> equations = read_input(argv[1]);
+  // Optional second argument is the number of threads solving the machines
+  unsigned int num_threads =
+      argc > 2 ? std::max(1UL, std::stoul(argv[2])) : 1;
 
   // Task 1
-  long long total_presses = get_total_tokens(equations);
+  long long total_presses = get_total_tokens(equations, num_threads);
   std::cout << "Total tokens to get the most prices: " << total_presses << "\n";
 
   // Task 2
   long long total_presses_with_conversion_error =
-      get_total_tokens_with_error(equations);
+      get_total_tokens_with_error(equations, num_threads);
   std::cout << "Total tokens to get the most prices with conversion error: "
             << total_presses_with_conversion_error << "\n";
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 #include <ostream>
 #include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "vector.h"
@@ -20,7 +25,13 @@ std::ostream& operator<<(std::ostream& os, const Robot& robot) {
   return os;
 }
 
-std::vector<Robot> read_input(std::string file_location) {
+struct Bathroom {
+  int width = 101, height = 103;
+  std::vector<Robot> robots {};
+};
+
+// An optional first line "size=<width>,<height>" overrides the default grid size
+Bathroom read_input(std::string file_location) {
   std::ifstream input_file;
   input_file.open(file_location);
   if (!input_file.is_open()) {
@@ -29,76 +40,266 @@ std::vector<Robot> read_input(std::string file_location) {
 
   std::string line;
   std::size_t offset {};
-  std::vector<Robot> robots {};
+  Bathroom bathroom {};
   while (std::getline(input_file, line)) {
+    if (line.starts_with("size=")) {
+      bathroom.width = std::stoi(line.substr(5), &offset);
+      bathroom.height = std::stoi(line.substr(6 + offset));
+      continue;
+    }
     int start_x = std::stoi(line.substr(line.find("p=") + 2), &offset);
     int start_y = std::stoi(line.substr(line.find("p=") + 3 + offset)); 
   
     int velocity_x = std::stoi(line.substr(line.find("v=") + 2), &offset);
     int velocity_y = std::stoi(line.substr(line.find("v=") + 3 + offset));
 
-    robots.push_back({{start_x, start_y}, {velocity_x, velocity_y}});
+    bathroom.robots.push_back({{start_x, start_y}, {velocity_x, velocity_y}});
   }
-  return robots;
+  return bathroom;
+}
+
+// Closed form of moves steps, in 64 bit so start + moves * velocity cannot overflow
+Vector get_robot_position(const Robot& robot, long long moves = 0, const int width = 101, const int height = 103) {
+  auto wrap = [](long long start, long long velocity, long long moves, long long size) {
+    long long pos = (start + (moves % size) * (velocity % size)) % size;
+    return static_cast<int>(pos < 0 ? pos + size : pos);
+  };
+  return {wrap(robot.start.x, robot.velocity.x, moves, width),
+          wrap(robot.start.y, robot.velocity.y, moves, height)};
 }
 
-Vector get_robot_position(const Robot& robot, int moves = 0, const int width = 101, const int height = 103) {
-  Vector pos = robot.start;
-  for(int i = 0; i < moves; ++i){
-    pos += robot.velocity;
-    pos.x = pos.x % width;
-    if(pos.x < 0) {
-      pos.x += width;
+/**
+ * Robots as structure of arrays. Velocities are stored modulo the grid size so
+ * all operands are non-negative, which lets advance_to() run one branch free
+ * loop per axis over all robots.
+ */
+class RobotSwarm {
+public:
+  RobotSwarm(const std::vector<Robot>& robots, int width = 101, int height = 103)
+      : width_(width), height_(height) {
+    for (auto* column : {&start_x_, &start_y_, &velocity_x_, &velocity_y_, &x_, &y_}) {
+      column->reserve(robots.size());
     }
-    pos.y = pos.y % height;
-    if(pos.y < 0) {
-      pos.y += height;
+    for (const auto& robot : robots) {
+      start_x_.push_back(robot.start.x);
+      start_y_.push_back(robot.start.y);
+      velocity_x_.push_back(((robot.velocity.x % width) + width) % width);
+      velocity_y_.push_back(((robot.velocity.y % height) + height) % height);
     }
+    x_ = start_x_;
+    y_ = start_y_;
   }
-  return pos;
-}
 
-// ===== Task 2 =====
-int get_safety_factor(const std::vector<Robot>& robots){
-  const std::size_t width = 101, height = 103;
-  
-  std::vector<Vector> final_positions {};
-  for(const auto& robot : robots) {
-    final_positions.push_back(get_robot_position(robot, 100, width, height));
+  // Moves every robot to its position after time steps
+  void advance_to(long long time) {
+    advance_axis(start_x_, velocity_x_, x_, time % width_, width_);
+    advance_axis(start_y_, velocity_y_, y_, time % height_, height_);
+  }
+
+  std::size_t size() const { return x_.size(); }
+  const std::vector<int>& start_x() const { return start_x_; }
+  const std::vector<int>& start_y() const { return start_y_; }
+  const std::vector<int>& velocity_x() const { return velocity_x_; }
+  const std::vector<int>& velocity_y() const { return velocity_y_; }
+  const std::vector<int>& x() const { return x_; }
+  const std::vector<int>& y() const { return y_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+private:
+  /**
+   * pos = (start + velocity * time) mod size with all operands in [0, size).
+   * The quotient comes from a float reciprocal, which is off by at most one
+   * as long as size * size fits into the 24 bit mantissa; one correction step
+   * in each direction fixes that without branches.
+   */
+  static void advance_axis(const std::vector<int>& start, const std::vector<int>& velocity,
+                           std::vector<int>& pos, int time, int size) {
+    const std::size_t n = pos.size();
+    if (static_cast<long long>(size) * size + size >= (1 << 24)) {
+      for (std::size_t i = 0; i < n; ++i) {
+        pos[i] = (start[i] + static_cast<long long>(velocity[i]) * time) % size;
+      }
+      return;
+    }
+    const float reciprocal = 1.0f / size;
+    const int* __restrict s = start.data();
+    const int* __restrict v = velocity.data();
+    int* __restrict p = pos.data();
+    for (std::size_t i = 0; i < n; ++i) {
+      const int val = s[i] + v[i] * time;
+      int rest = val - static_cast<int>(static_cast<float>(val) * reciprocal) * size;
+      rest += (rest < 0) * size;
+      rest -= (rest >= size) * size;
+      p[i] = rest;
+    }
+  }
+
+  const int width_, height_;
+  std::vector<int> start_x_{}, start_y_{}, velocity_x_{}, velocity_y_{};
+  std::vector<int> x_{}, y_{};
+};
+
+/**
+ * Counts robots per partition of the grid. Every coordinate is mapped to its
+ * partition through a lookup table per axis, coordinates that belong to no
+ * partition map to one extra "discard" bin, so binning a robot is two loads
+ * and an add. Threads count separate blocks of robots into their own
+ * histograms, which are summed up at the end.
+ */
+class SpatialHistogram {
+public:
+  // The puzzle's quadrants, the middle row and column of odd sizes belong to none
+  static SpatialHistogram quadrants(int width, int height) {
+    auto halves = [](int size) {
+      std::vector<int> bins(size);
+      for (int pos = 0; pos < size; ++pos) {
+        bins[pos] = 2 * pos + 1 < size ? 0 : (2 * pos + 1 > size ? 1 : 2);
+      }
+      return bins;
+    };
+    return {halves(width), halves(height), 2, 2};
   }
 
-  int upper_left = 0, upper_right = 0, lower_left = 0, lower_right = 0;
-  for(const auto& position : final_positions) {
-    if(position.x < width / 2){
-      if (position.y < height / 2) {
-        ++upper_left;
-      } else if (position.y > height / 2) {
-        ++lower_left;
+  // tiles x tiles partitions of (almost) equal size
+  static SpatialHistogram tiles(int width, int height, int tiles) {
+    auto split = [tiles](int size) {
+      std::vector<int> bins(size);
+      for (int pos = 0; pos < size; ++pos) {
+        bins[pos] = static_cast<long long>(pos) * tiles / size;
       }
-    } else if (position.x > width / 2) {
-      if (position.y < height / 2) {
-        ++upper_right;
-      } else if (position.y > height / 2) {
-        ++lower_right;
+      return bins;
+    };
+    return {split(width), split(height), tiles, tiles};
+  }
+
+  // Robots per partition, row-major
+  std::vector<long long> count(const RobotSwarm& swarm, unsigned int num_threads = 1) const {
+    const std::size_t stride = partitions_x_ + 1;
+    const std::size_t bins = stride * (partitions_y_ + 1);
+    std::vector<std::vector<long long>> per_thread(num_threads, std::vector<long long>(bins, 0));
+    const std::size_t block = (swarm.size() + num_threads - 1) / num_threads;
+    {
+      std::vector<std::jthread> threads {};
+      for (unsigned int thread = 0; thread < num_threads; ++thread) {
+        const std::size_t from = std::min(swarm.size(), thread * block);
+        const std::size_t to = std::min(swarm.size(), from + block);
+        threads.emplace_back([&, from, to, thread] {
+          auto& histogram = per_thread[thread];
+          for (std::size_t i = from; i < to; ++i) {
+            ++histogram[bin_y_[swarm.y()[i]] * stride + bin_x_[swarm.x()[i]]];
+          }
+        });
       }
     }
+
+    std::vector<long long> counts(partitions_x_ * partitions_y_, 0);
+    for (const auto& histogram : per_thread) {
+      for (int y = 0; y < partitions_y_; ++y) {
+        for (int x = 0; x < partitions_x_; ++x) {
+          counts[y * partitions_x_ + x] += histogram[y * stride + x];
+        }
+      }
+    }
+    return counts;
   }
-  return upper_left * upper_right * lower_left * lower_right;
+
+private:
+  SpatialHistogram(std::vector<int> bin_x, std::vector<int> bin_y, int partitions_x, int partitions_y)
+      : bin_x_(bin_x), bin_y_(bin_y), partitions_x_(partitions_x), partitions_y_(partitions_y) {}
+
+  std::vector<int> bin_x_, bin_y_;
+  int partitions_x_, partitions_y_;
+};
+
+// ===== Task 1 =====
+long long get_safety_factor(const std::vector<Robot>& robots, int width = 101, int height = 103,
+                            unsigned int num_threads = 1){
+  RobotSwarm swarm{robots, width, height};
+  swarm.advance_to(100);
+
+  const auto quadrants = SpatialHistogram::quadrants(width, height).count(swarm, num_threads);
+  return std::accumulate(quadrants.begin(), quadrants.end(), 1LL, std::multiplies<>());
 }
 
-void display_robots(const std::vector<Robot>& robots, int moves = 0){
-  const std::size_t width = 101, height = 103;
-  
-  std::vector<Vector> final_positions {};
-  for(const auto& robot : robots) {
-    final_positions.push_back(get_robot_position(robot, moves, width, height));
+// ===== Task 2 =====
+void display_robots(const std::vector<Robot>& robots, long long moves = 0,
+                    const std::size_t width = 101, const std::size_t height = 103){
+  RobotSwarm swarm{robots, static_cast<int>(width), static_cast<int>(height)};
+  swarm.advance_to(moves);
+
+  array2D::Array2D<char> array {width, height, ' '};
+  for(std::size_t i = 0; i < swarm.size(); ++i) {
+    array.at(swarm.x()[i], swarm.y()[i]) = 'X';
   }
-  
-  Array2D::Array2D<char> array {width, height, ' '};
-  for(const auto& pos : final_positions) {
-    array.at(pos.x, pos.y) = 'X';
+  array2D::print_array<char>(array, [](char c) { return std::string(1, c); });
+}
+
+/**
+ * Spread of the robots along one axis for every time in [0, size), as size^2
+ * times the variance. Each thread takes a block of times, places the robots
+ * once at its start and then only steps them by their velocity.
+ */
+std::vector<long long> get_axis_spread(const std::vector<int>& start, const std::vector<int>& velocity,
+                                       int size, unsigned int num_threads) {
+  const long long n = start.size();
+  std::vector<long long> spread(size, 0);
+  const int block = (size + num_threads - 1) / num_threads;
+  {
+    std::vector<std::jthread> threads {};
+    for (unsigned int thread = 0; thread < num_threads; ++thread) {
+      const int from = std::min(size, static_cast<int>(thread) * block);
+      const int to = std::min(size, from + block);
+      threads.emplace_back([&, from, to] {
+        std::vector<int> pos(n);
+        for (long long i = 0; i < n; ++i) {
+          pos[i] = (start[i] + static_cast<long long>(velocity[i]) * from) % size;
+        }
+        for (int time = from; time < to; ++time) {
+          long long sum = 0, sum_of_squares = 0;
+          for (long long i = 0; i < n; ++i) {
+            sum += pos[i];
+            sum_of_squares += static_cast<long long>(pos[i]) * pos[i];
+            pos[i] += velocity[i];
+            pos[i] -= (pos[i] >= size) * size;
+          }
+          spread[time] = n * sum_of_squares - sum * sum;
+        }
+      });
+    }
   }
-  Array2D::print_array(array);
+  return spread;
+}
+
+/**
+ * The picture appears when the robots cluster on both axes at once. x repeats
+ * every width and y every height steps, so the best time per axis is found
+ * separately and combined with the chinese remainder theorem. If the two
+ * periods share a factor and the residues do not fit, all times up to the
+ * common period are scored instead.
+ */
+long long find_easter_egg(const RobotSwarm& swarm, unsigned int num_threads = 1) {
+  const int width = swarm.width(), height = swarm.height();
+  const auto spread_x = get_axis_spread(swarm.start_x(), swarm.velocity_x(), width, num_threads);
+  const auto spread_y = get_axis_spread(swarm.start_y(), swarm.velocity_y(), height, num_threads);
+  const long long best_x = std::ranges::min_element(spread_x) - spread_x.begin();
+  const long long best_y = std::ranges::min_element(spread_y) - spread_y.begin();
+
+  const long long period = std::lcm(static_cast<long long>(width), height);
+  for (long long time = best_x; time < period; time += width) {
+    if (time % height == best_y) {
+      return time;
+    }
+  }
+
+  long long best_time = 0;
+  for (long long time = 0; time < period; ++time) {
+    if (spread_x[time % width] + spread_y[time % height] <
+        spread_x[best_time % width] + spread_y[best_time % height]) {
+      best_time = time;
+    }
+  }
+  return best_time;
 }
 
 int main(int argc, char **argv) {
@@ -108,21 +309,17 @@ int main(int argc, char **argv) {
   }
 
   // First argument is input file location
-  std::vector<Robot> robots = read_input(argv[1]);
+  Bathroom bathroom = read_input(argv[1]);
+  const auto& robots = bathroom.robots;
+  // Optional second argument is the number of threads
+  unsigned int num_threads = argc > 2 ? std::max(1UL, std::stoul(argv[2])) : 1;
 
   // Task 1 : Safety factor
-  int safety_factor = get_safety_factor(robots);
+  long long safety_factor = get_safety_factor(robots, bathroom.width, bathroom.height, num_threads);
   std::cout << "Safety factor: " << safety_factor << "\n";
   // Task 2 : Tree easter egg
-  char c = 'y';
-  int i = 79;
-  while (c != 'n'){
-    std::cout << "i = " << i << "\n";
-    display_robots(robots,i);
-    i += 101;
-    std::cout << "\n";
-    std::cout << "Continue?(y/n)" << "\n";
-    std::cin >> c;
-  }
+  long long easter_egg = find_easter_egg(RobotSwarm{robots, bathroom.width, bathroom.height}, num_threads);
+  std::cout << "Easter egg after " << easter_egg << " seconds" << "\n";
+  display_robots(robots, easter_egg, bathroom.width, bathroom.height);
 
 }
\ No newline at end of file
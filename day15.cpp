@@ -1,10 +1,17 @@
-#include <cassert>
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include "array2d.h"
 
@@ -13,72 +20,153 @@ constexpr typename std::underlying_type<E>::type to_underlying(E e) noexcept {
   return static_cast<typename std::underlying_type<E>::type>(e);
 }
 
-enum class Tile : int { Empty = 0, Wall = 1, Box = 2, Robot = 3 };
+enum class Tile : std::uint8_t {
+  Empty = 0,
+  Wall = 1,
+  Box = 2,
+  Robot = 3,
+  BoxLeft = 4,
+  BoxRight = 5
+};
 
-class TileArray : public array2D::Array2D<int> {
+/**
+ * Warehouse with one byte per tile. The tiles are surrounded by an extra ring
+ * of walls, so moves never leave the buffer and run on raw indices: a step in
+ * any direction is adding a precomputed offset. Coordinates in the interface
+ * are those of the puzzle, without the ring.
+ */
+class TileArray {
 public:
   TileArray(std::size_t width, std::size_t height,
             Tile defaultTile = Tile::Empty)
-      : array2D::Array2D<int>(width, height, static_cast<int>(defaultTile)) {}
-
-  TileArray(const array2D::Array2D<int> &arr) : array2D::Array2D<int>(arr) {
-    bool found = false;
-    for (int x = 0; x < length(); ++x) {
-      for (int y = 0; y < height(); ++y) {
-        if (get_tile_at(x, y) == Tile::Robot) {
-          robot_x = x;
-          robot_y = y;
-          found = true;
-          break;
+      : length_(width), height_(height), stride_(width + 2),
+        tiles_(stride_ * (height + 2), Tile::Wall),
+        pushed_(tiles_.size(), 0) {
+    offsets_ = {-static_cast<std::ptrdiff_t>(stride_), 1,
+                static_cast<std::ptrdiff_t>(stride_), -1};
+    frontier_.reserve(tiles_.size());
+    for (std::size_t y = 0; y < height_; ++y) {
+      std::fill_n(&tiles_[index(0, y)], length_, defaultTile);
+    }
+    total_gps_score_ = recalculate_total_gps_score();
+  }
+
+  TileArray(const array2D::Array2D<int> &arr)
+      : TileArray(arr.length(), arr.height()) {
+    for (std::size_t y = 0; y < height_; ++y) {
+      for (std::size_t x = 0; x < length_; ++x) {
+        tiles_[index(x, y)] = static_cast<Tile>(arr.cat(x, y));
+        if (tiles_[index(x, y)] == Tile::Robot) {
+          robot_ = index(x, y);
         }
       }
-      if (found) {
-        break;
-      }
     }
+    total_gps_score_ = recalculate_total_gps_score();
   }
 
+  std::size_t length() const { return length_; }
+  std::size_t height() const { return height_; }
+
   Tile get_tile_at(std::size_t x, std::size_t y) const {
-    auto at_pos = cat(x, y);
-    assert((0 <= at_pos && at_pos <= 3));
-    return static_cast<Tile>(at_pos);
+    return tiles_[index(x, y)];
   }
 
   void set_tile_at(std::size_t x, std::size_t y, Tile tile) {
-    at(x, y) = static_cast<int>(tile);
+    total_gps_score_ -= calculate_gps_score(x, y);
+    tiles_[index(x, y)] = tile;
+    total_gps_score_ += calculate_gps_score(x, y);
     if (tile == Tile::Robot) {
-      robot_x = x;
-      robot_y = y;
+      robot_ = index(x, y);
     }
   }
 
   void move(char direction) {
-    int dir_x = 0, dir_y = 0;
-    if (direction == '^') {
-      dir_y = -1;
-    } else if (direction == '>') {
-      dir_x = 1;
-    } else if (direction == 'v') {
-      dir_y = 1;
-    } else if (direction == '<') {
-      dir_x = -1;
-    }
-
-    int i = 1;
-    std::size_t start_x = robot_x, start_y = robot_y;
-    Tile tile = get_tile_at(start_x + i * dir_x, start_y + i * dir_y);
-    while (tile != Tile::Wall && tile != Tile::Empty) {
-      ++i;
-      tile = get_tile_at(start_x + i * dir_x, start_y + i * dir_y);
-    }
-    if (tile == Tile::Empty) {
-      for (; i > 0; --i) {
-        set_tile_at(
-            robot_x + i * dir_x, robot_y + i * dir_y,
-            get_tile_at(robot_x + (i - 1) * dir_x, robot_y + (i - 1) * dir_y));
+    switch (direction) {
+    case '^':
+      push_frontier(offsets_[0]);
+      break;
+    case '>':
+      push_row(1);
+      break;
+    case 'v':
+      push_frontier(offsets_[2]);
+      break;
+    case '<':
+      push_row(-1);
+      break;
+    default:
+      break;
+    }
+  }
+
+  /**
+   * Horizontal push: the run of boxes in front of the robot and the robot
+   * itself shift by one tile with a single memmove, if the run ends in an
+   * empty tile. Every box in the run changes its x by one.
+   */
+  void push_row(std::ptrdiff_t step) {
+    Tile *robot = tiles_.data() + robot_;
+    Tile *end = robot + step;
+    long long boxes = 0;
+    while (*end != Tile::Wall && *end != Tile::Empty) {
+      boxes += counts_for_gps(*end);
+      end += step;
+    }
+    if (*end == Tile::Wall) {
+      return;
+    }
+    const std::size_t run = (end - robot) * step;
+    if (step > 0) {
+      std::memmove(robot + 1, robot, run);
+    } else {
+      std::memmove(end, end + 1, run);
+    }
+    *robot = Tile::Empty;
+    robot_ += step;
+    total_gps_score_ += boxes * step;
+  }
+
+  /**
+   * Vertical push: a wide box pushes every box touching either of its halves,
+   * so the moving tiles are collected as a frontier, breadth first, into a
+   * scratch buffer sized for the whole warehouse. pushed_ stamps the tiles of
+   * the current move to avoid duplicates without ever clearing it. If no tile
+   * runs into a wall, the tiles move in reverse order, farthest first.
+   */
+  void push_frontier(std::ptrdiff_t step) {
+    ++stamp_;
+    frontier_.clear();
+    add_to_frontier(robot_);
+    for (std::size_t idx = 0; idx < frontier_.size(); ++idx) {
+      const std::size_t next = frontier_[idx] + step;
+      switch (tiles_[next]) {
+      case Tile::Wall:
+        return;
+      case Tile::Box:
+        add_to_frontier(next);
+        break;
+      case Tile::BoxLeft:
+        add_to_frontier(next);
+        add_to_frontier(next + 1);
+        break;
+      case Tile::BoxRight:
+        add_to_frontier(next);
+        add_to_frontier(next - 1);
+        break;
+      default:
+        break;
       }
-      set_tile_at(start_x, start_y, Tile::Empty);
     }
+
+    long long boxes = 0;
+    Tile *tiles = tiles_.data();
+    for (auto iter = frontier_.rbegin(); iter != frontier_.rend(); ++iter) {
+      boxes += counts_for_gps(tiles[*iter]);
+      tiles[*iter + step] = tiles[*iter];
+      tiles[*iter] = Tile::Empty;
+    }
+    robot_ += step;
+    total_gps_score_ += boxes * (step > 0 ? 100 : -100);
   }
 
   void move(std::string movements) {
@@ -88,37 +176,167 @@ public:
   }
 
   int calculate_gps_score(std::size_t x, std::size_t y) const {
-    if (get_tile_at(x, y) == Tile::Box) {
+    if (counts_for_gps(get_tile_at(x, y))) {
       return 100 * y + x;
     }
     return 0;
   }
 
-  int calculate_total_gps_score() const {
-    int sum = 0;
-    for (int x = 0; x < length(); ++x) {
-      for (int y = 0; y < height(); ++y) {
+  // Maintained by set_tile_at and the moves, O(1) after every move
+  long long calculate_total_gps_score() const { return total_gps_score_; }
+
+  // Full row-major rescan, to validate the running score
+  long long recalculate_total_gps_score() const {
+    long long sum = 0;
+    for (std::size_t y = 0; y < height(); ++y) {
+      for (std::size_t x = 0; x < length(); ++x) {
         sum += calculate_gps_score(x, y);
       }
     }
     return sum;
   }
 
+  // Everything needed to restore the warehouse, without the scratch space
+  struct Snapshot {
+    std::vector<Tile> tiles;
+    std::size_t robot;
+    long long total_gps_score;
+  };
+
+  Snapshot snapshot() const { return {tiles_, robot_, total_gps_score_}; }
+
+  void restore(const Snapshot &snapshot) {
+    tiles_ = snapshot.tiles;
+    robot_ = snapshot.robot;
+    total_gps_score_ = snapshot.total_gps_score;
+  }
+
+  array2D::Array2D<int> to_array() const {
+    array2D::Array2D<int> array(length_, height_);
+    for (std::size_t y = 0; y < height_; ++y) {
+      for (std::size_t x = 0; x < length_; ++x) {
+        array.at(x, y) = static_cast<int>(get_tile_at(x, y));
+      }
+    }
+    return array;
+  }
+
 private:
-  std::size_t robot_x = 0, robot_y = 0;
+  static bool counts_for_gps(Tile tile) {
+    return tile == Tile::Box || tile == Tile::BoxLeft;
+  }
+
+  std::size_t index(std::size_t x, std::size_t y) const {
+    return (y + 1) * stride_ + x + 1;
+  }
+
+  void add_to_frontier(std::size_t idx) {
+    if (pushed_[idx] != stamp_) {
+      pushed_[idx] = stamp_;
+      frontier_.push_back(idx);
+    }
+  }
+
+  std::size_t length_, height_, stride_;
+  std::vector<Tile> tiles_;
+  // Index offset of one step North, East, South, West
+  std::array<std::ptrdiff_t, 4> offsets_{};
+  std::size_t robot_ = 0;
+  long long total_gps_score_ = 0;
+
+  // Scratch space of push_frontier, allocated once
+  std::vector<std::size_t> frontier_{};
+  std::vector<unsigned int> pushed_;
+  unsigned int stamp_ = 0;
+};
+
+/**
+ * Records a movement script compactly (2 bits per move) together with a
+ * snapshot of the warehouse every interval moves. The state after any move
+ * is then one snapshot copy plus at most interval - 1 replayed moves away.
+ */
+class Replay {
+public:
+  Replay(const TileArray &warehouse, std::size_t interval = 100000)
+      : interval_(interval), current_(warehouse),
+        checkpoints_{warehouse.snapshot()} {}
+
+  void move(char direction) {
+    static const std::string directions = "^>v<";
+    const auto code = directions.find(direction);
+    if (code == std::string::npos) {
+      return;
+    }
+    if (moves_ % 4 == 0) {
+      log_.push_back(0);
+    }
+    log_.back() |= code << (2 * (moves_ % 4));
+    ++moves_;
+    current_.move(direction);
+    if (moves_ % interval_ == 0) {
+      checkpoints_.push_back(current_.snapshot());
+    }
+  }
+
+  std::size_t size() const { return moves_; }
+  const TileArray &current() const { return current_; }
+
+  // The warehouse after the first `moves` moves
+  TileArray seek(std::size_t moves) const {
+    if (moves > moves_) {
+      throw std::out_of_range("Replay has only " + std::to_string(moves_) +
+                              " moves!");
+    }
+    static const std::string directions = "^>v<";
+    TileArray warehouse = current_;
+    warehouse.restore(checkpoints_[moves / interval_]);
+    for (std::size_t move = moves - moves % interval_; move < moves; ++move) {
+      warehouse.move(directions[(log_[move / 4] >> (2 * (move % 4))) & 3]);
+    }
+    return warehouse;
+  }
+
+private:
+  const std::size_t interval_;
+  TileArray current_;
+  std::vector<TileArray::Snapshot> checkpoints_;
+  std::vector<std::uint8_t> log_{};
+  std::size_t moves_ = 0;
 };
 
+// Part 2: everything except the robot is twice as wide
+TileArray widen(const TileArray &warehouse) {
+  array2D::Array2D<int> wide(2 * warehouse.length(), warehouse.height(),
+                             static_cast<int>(Tile::Empty));
+  for (std::size_t y = 0; y < warehouse.height(); ++y) {
+    for (std::size_t x = 0; x < warehouse.length(); ++x) {
+      Tile left = warehouse.get_tile_at(x, y), right = left;
+      if (left == Tile::Box) {
+        left = Tile::BoxLeft;
+        right = Tile::BoxRight;
+      } else if (left == Tile::Robot) {
+        right = Tile::Empty;
+      }
+      wide.at(2 * x, y) = static_cast<int>(left);
+      wide.at(2 * x + 1, y) = static_cast<int>(right);
+    }
+  }
+  return TileArray(wide);
+}
+
 void print(const TileArray &warehouse) {
   std::function<std::string(int)> to_char = [](const int &v) -> std::string {
     const static std::map<int, std::string> tile_to_char{
         {static_cast<int>(Tile::Wall), "#"},
         {static_cast<int>(Tile::Robot), "@"},
         {static_cast<int>(Tile::Box), "O"},
+        {static_cast<int>(Tile::BoxLeft), "["},
+        {static_cast<int>(Tile::BoxRight), "]"},
         {static_cast<int>(Tile::Empty), " "},
     };
     return tile_to_char.at(v);
   };
-  array2D::print_array(warehouse, to_char);
+  array2D::print_array(warehouse.to_array(), to_char);
 }
 
 // ===== Read Input =====
@@ -136,24 +354,31 @@ TileArray read_warehouse(std::string file_location) {
   return TileArray(array);
 }
 
-std::string read_directions(std::string file_location) {
-  std::string directions = "";
-
-  std::string line;
+// Hands every direction after the warehouse map to apply while reading, the
+// script is never held in memory. Returns the number of directions.
+template <class Func>
+std::size_t stream_directions(std::string file_location, Func &&apply) {
   std::ifstream input_file;
   input_file.open(file_location);
+  if (!input_file.is_open()) {
+    throw std::invalid_argument("Unable to open file at " + file_location);
+  }
+  std::string line;
   // Advance to directions part
   while (std::getline(input_file, line) && line != "") {
   }
 
-  while (std::getline(input_file, line)) {
-    directions += line;
-  }
-  return directions;
+  std::size_t num_directions = 0;
+  std::for_each(std::istreambuf_iterator<char>(input_file),
+                std::istreambuf_iterator<char>(), [&](char c) {
+                  if (c == '^' || c == '>' || c == 'v' || c == '<') {
+                    apply(c);
+                    ++num_directions;
+                  }
+                });
+  return num_directions;
 }
 
-int get_sum_of_gps_coordinates(const TileArray &warehouse) { return 0; }
-
 int main(int argc, char **argv) {
   if (argc < 2) {
     std::cout << "Not enough arguments! " << "\n";
@@ -162,9 +387,34 @@ int main(int argc, char **argv) {
 
   // First argument is input file location
   TileArray warehouse = read_warehouse(argv[1]);
-  std::string directions = read_directions(argv[1]);
+  TileArray wide_warehouse = widen(warehouse);
+  // Optional second argument: show the warehouse after that many moves
+  std::optional<Replay> replay{};
+  if (argc > 2) {
+    replay.emplace(warehouse);
+  }
+
+  stream_directions(argv[1], [&](char direction) {
+    warehouse.move(direction);
+    wide_warehouse.move(direction);
+    if (replay) {
+      replay->move(direction);
+    }
+  });
+
   // Task 1 : Sum of gps coordinates
-  warehouse.move(directions);
-  int total_gps_score = warehouse.calculate_total_gps_score();
+  long long total_gps_score = warehouse.calculate_total_gps_score();
   std::cout << "Sum of gps coordinates: " << total_gps_score << "\n";
-}
\ No newline at end of file
+  // Task 2 : Sum of gps coordinates in the wide warehouse
+  long long total_wide_gps_score = wide_warehouse.calculate_total_gps_score();
+  std::cout << "Sum of gps coordinates in wide warehouse: "
+            << total_wide_gps_score << "\n";
+
+  if (replay) {
+    std::size_t moves = std::stoull(argv[2]);
+    TileArray state = replay->seek(moves);
+    std::cout << "After " << moves << " moves (gps "
+              << state.calculate_total_gps_score() << "):" << "\n";
+    print(state);
+  }
+}
@@ -1,14 +1,19 @@
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <climits>
+#include <cstdint>
 #include <cstddef>
 #include <functional>
 #include <iostream>
 #include <map>
+#include <numeric>
 #include <ostream>
-#include <set>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "array2d.h"
@@ -107,264 +112,453 @@ std::ostream &operator<<(std::ostream &os, const Location &loc) {
   return os;
 }
 
+constexpr int kSTEP_COST = 1;
+constexpr int kTURN_COST = 1000;
+constexpr int kUNREACHED = INT_MAX;
+
+/**
+ * Monotone priority queue for integer keys: a popped key is never larger than
+ * any key pushed afterwards. Bucket i holds keys whose highest bit differing
+ * from the last popped key is bit i - 1, so every key is redistributed at most
+ * once per bit.
+ */
+template <typename T> class RadixHeap {
+public:
+  void push(unsigned key, T value) {
+    assert(key >= last_);
+    buckets_[bucket(key)].push_back({key, value});
+    ++size_;
+  }
+
+  std::pair<unsigned, T> pop() {
+    if (buckets_[0].empty()) {
+      std::size_t i = 1;
+      while (buckets_[i].empty()) {
+        ++i;
+      }
+      last_ = std::ranges::min_element(buckets_[i], {},
+                                       &std::pair<unsigned, T>::first)
+                  ->first;
+      for (const auto &entry : buckets_[i]) {
+        buckets_[bucket(entry.first)].push_back(entry);
+      }
+      buckets_[i].clear();
+    }
+    auto entry = buckets_[0].back();
+    buckets_[0].pop_back();
+    --size_;
+    return entry;
+  }
+
+  bool empty() const { return size_ == 0; }
+
+private:
+  std::size_t bucket(unsigned key) const {
+    return key == last_ ? 0 : std::bit_width(key ^ last_);
+  }
+
+  std::array<std::vector<std::pair<unsigned, T>>, 33> buckets_{};
+  unsigned last_ = 0;
+  std::size_t size_ = 0;
+};
+
+/**
+ * Costs of all num_states states from the nearest source. for_each_edge(state,
+ * relax) calls relax(next, weight) for every edge leaving state.
+ */
+template <typename ForEachEdge>
+std::vector<int> dijkstra(std::size_t num_states,
+                          const std::vector<std::size_t> &sources,
+                          ForEachEdge for_each_edge) {
+  std::vector<int> costs(num_states, kUNREACHED);
+  RadixHeap<std::size_t> queue{};
+  for (std::size_t source : sources) {
+    costs[source] = 0;
+    queue.push(0, source);
+  }
+
+  while (!queue.empty()) {
+    auto [cost, current] = queue.pop();
+    if (static_cast<int>(cost) != costs[current]) {
+      continue; // Stale entry
+    }
+    for_each_edge(current, [&, cost](std::size_t next, int weight) {
+      if (static_cast<int>(cost) + weight < costs[next]) {
+        costs[next] = cost + weight;
+        queue.push(cost + weight, next);
+      }
+    });
+  }
+  return costs;
+}
+
+/**
+ * One bit per cell of a maze, packed into 64-bit words.
+ */
+class TileSet {
+public:
+  TileSet(std::size_t length, std::size_t height)
+      : length_(length), words_((length * height + 63) / 64, 0) {}
+
+  bool contains(std::size_t x, std::size_t y) const {
+    const std::size_t cell = y * length_ + x;
+    return words_[cell / 64] >> (cell % 64) & 1;
+  }
+
+  void insert(std::size_t x, std::size_t y) {
+    const std::size_t cell = y * length_ + x;
+    words_[cell / 64] |= std::uint64_t{1} << (cell % 64);
+  }
+
+  std::size_t size() const {
+    std::size_t size = 0;
+    for (std::uint64_t word : words_) {
+      size += std::popcount(word);
+    }
+    return size;
+  }
+
+  std::size_t num_words() const { return words_.size(); }
+  std::uint64_t &word(std::size_t i) { return words_[i]; }
+
+private:
+  std::size_t length_;
+  std::vector<std::uint64_t> words_;
+};
+
+/**
+ * Dijkstra over the states (cell, heading). Costs live in four layers, one per
+ * Direction, with state = heading * cells + y * length + x. Every state has at
+ * most three edges: a step forward (kSTEP_COST) and two quarter turns in place
+ * (kTURN_COST). The maze is expected to be enclosed by walls.
+ */
 class DijkstraPathing {
 public:
   DijkstraPathing(const TileArray &reindeer_maze, Location start, Location end)
       : start_(start), end_({end.x, end.y, Direction::NONE}),
-        maze_(reindeer_maze),
-        costs_(maze_.length(), maze_.height(), INT_MAX - 2000),
-        coming_from_(maze_.length(), maze_.height(),
-                     static_cast<int>(Direction::NONE)) {
-    costs_.at(start_.x, start_.y) = 0;
+        maze_(reindeer_maze), cells_(maze_.length() * maze_.height()),
+        steps_{-static_cast<std::ptrdiff_t>(maze_.length()), 1,
+               static_cast<std::ptrdiff_t>(maze_.length()), -1} {
     path_length_ = find_path_length();
   }
 
   int find_path_length() {
-    std::multimap<int, Location, std::greater<>> queue{{0, start_}};
-
-    while (!queue.empty()) {
-      auto iter = --queue.end();
-      auto current = *iter;
-      queue.erase(iter);
-      // North
-      if (maze_.get_tile_at(current.second.x, current.second.y - 1) !=
-          Tile::Wall) {
-        int cost = current.first + 1;
-        if (current.second.direction != Direction::NORTH) {
-          cost += 1000;
-        } else { // Skip crosses (+)
-          if (maze_.get_tile_at(current.second.x, current.second.y - 2) !=
-              Tile::Wall) {
-            if (cost + 1 < costs_.at(current.second.x, current.second.y - 2)) {
-              costs_.at(current.second.x, current.second.y - 2) = cost + 1;
-              coming_from_.at(current.second.x, current.second.y - 2) =
-                  static_cast<int>(Direction::SOUTH);
-              queue.insert(
-                  {cost + 1,
-                   {current.second.x, current.second.y - 2, Direction::NORTH}});
-            }
-          }
-        }
-        Location loc{current.second.x, current.second.y - 1, Direction::NORTH};
-        if (cost < costs_.at(loc.x, loc.y)) {
-          costs_.at(loc.x, loc.y) = cost;
-          coming_from_.at(loc.x, loc.y) = static_cast<int>(Direction::SOUTH);
-          queue.insert({cost, loc});
-        }
+    costs_ = search({state(start_.x, start_.y, start_.direction)}, false);
+    return get_cost(end_.x, end_.y);
+  }
+
+  /**
+   * Costs of all states from the nearest source. With reversed set every edge
+   * is walked backwards, so the result is the cost from each state to the
+   * nearest source instead.
+   */
+  std::vector<int> search(const std::vector<std::size_t> &sources,
+                          bool reversed) const {
+    return dijkstra(4 * cells_, sources, [&](std::size_t current, auto relax) {
+      const std::size_t heading = current / cells_;
+      const std::size_t cell = current % cells_;
+      const std::size_t ahead =
+          reversed ? cell - steps_[heading] : cell + steps_[heading];
+      if (!is_wall(ahead)) {
+        relax(heading * cells_ + ahead, kSTEP_COST);
       }
-      // East
-      if (maze_.get_tile_at(current.second.x + 1, current.second.y) !=
-          Tile::Wall) {
-        int cost = current.first + 1;
-        if (current.second.direction != Direction::EAST) {
-          cost += 1000;
-        } else { // Skip crosses (+)
-          if (maze_.get_tile_at(current.second.x + 2, current.second.y) !=
-              Tile::Wall) {
-            if (cost + 1 < costs_.at(current.second.x + 2, current.second.y)) {
-              costs_.at(current.second.x + 2, current.second.y) = cost + 1;
-              coming_from_.at(current.second.x + 2, current.second.y) =
-                  static_cast<int>(Direction::WEST);
-              queue.insert(
-                  {cost + 1,
-                   {current.second.x + 2, current.second.y, Direction::EAST}});
-            }
-          }
-        }
-        Location loc{current.second.x + 1, current.second.y, Direction::EAST};
-        if (cost < costs_.at(loc.x, loc.y)) {
-          costs_.at(loc.x, loc.y) = cost;
-          coming_from_.at(loc.x, loc.y) = static_cast<int>(Direction::WEST);
-          queue.insert({cost, loc});
-        }
+      relax((heading + 1) % 4 * cells_ + cell, kTURN_COST);
+      relax((heading + 3) % 4 * cells_ + cell, kTURN_COST);
+    });
+  }
+
+  int get_path_length() { return path_length_; };
+
+  /**
+   * Cost of reaching (x, y) facing direction, or the cheapest over all
+   * headings for Direction::NONE.
+   */
+  int get_cost(std::size_t x, std::size_t y,
+               Direction direction = Direction::NONE) const {
+    if (direction != Direction::NONE) {
+      return costs_[state(x, y, direction)];
+    }
+    int cost = kUNREACHED;
+    for (std::size_t heading = 0; heading < 4; ++heading) {
+      cost = std::min(cost, costs_[heading * cells_ + y * maze_.length() + x]);
+    }
+    return cost;
+  }
+
+  array2D::Array2D<int> get_costs() const {
+    array2D::Array2D<int> costs(maze_.length(), maze_.height(), kUNREACHED);
+    for (std::size_t y = 0; y < maze_.height(); ++y) {
+      for (std::size_t x = 0; x < maze_.length(); ++x) {
+        costs.at(x, y) = get_cost(x, y);
       }
-      // South
-      if (maze_.get_tile_at(current.second.x, current.second.y + 1) !=
-          Tile::Wall) {
-        int cost = current.first + 1;
-        if (current.second.direction != Direction::SOUTH) {
-          cost += 1000;
-        } else { // Skip crosses (+)
-          if (maze_.get_tile_at(current.second.x, current.second.y + 2) !=
-              Tile::Wall) {
-            if (cost + 1 < costs_.at(current.second.x, current.second.y + 2)) {
-              costs_.at(current.second.x, current.second.y + 2) = cost + 1;
-              coming_from_.at(current.second.x, current.second.y + 2) =
-                  static_cast<int>(Direction::NORTH);
-              queue.insert(
-                  {cost + 1,
-                   {current.second.x, current.second.y + 2, Direction::SOUTH}});
+    }
+    return costs;
+  }
+
+  /**
+   * Tiles on any cheapest path. A state lies on one if its cost from the start
+   * plus its cost to the end (searched backwards from all end headings) equals
+   * the path length. Each thread marks a band of whole words of the TileSet.
+   */
+  TileSet get_optimal_seating_spots(unsigned int num_threads = 1) const {
+    std::vector<std::size_t> ends{};
+    for (std::size_t heading = 0; heading < 4; ++heading) {
+      ends.push_back(heading * cells_ + end_.y * maze_.length() + end_.x);
+    }
+    const std::vector<int> costs_to_end = search(ends, true);
+
+    TileSet optimal_seating_spots(maze_.length(), maze_.height());
+    const std::size_t num_words = optimal_seating_spots.num_words();
+    const std::size_t band = (num_words + num_threads - 1) / num_threads;
+    auto mark = [&](std::size_t from, std::size_t to) {
+      for (std::size_t i = from; i < to; ++i) {
+        std::uint64_t word = 0;
+        const std::size_t last = std::min(64 * i + 64, cells_);
+        for (std::size_t cell = 64 * i; cell < last; ++cell) {
+          for (std::size_t heading = 0; heading < 4; ++heading) {
+            const std::size_t s = heading * cells_ + cell;
+            if (costs_[s] != kUNREACHED && costs_to_end[s] != kUNREACHED &&
+                costs_[s] + costs_to_end[s] == path_length_) {
+              word |= std::uint64_t{1} << (cell % 64);
             }
           }
         }
-        Location loc{current.second.x, current.second.y + 1, Direction::SOUTH};
-        if (cost < costs_.at(loc.x, loc.y)) {
-          costs_.at(loc.x, loc.y) = cost;
-          coming_from_.at(loc.x, loc.y) = static_cast<int>(Direction::NORTH);
-          queue.insert({cost, loc});
-        }
+        optimal_seating_spots.word(i) = word;
       }
-      // West
-      if (maze_.get_tile_at(current.second.x - 1, current.second.y) !=
-          Tile::Wall) {
-        int cost = current.first + 1;
-        if (current.second.direction != Direction::WEST) {
-          cost += 1000;
-        } else { // Skip crosses (+)
-          if (maze_.get_tile_at(current.second.x - 2, current.second.y) !=
-              Tile::Wall) {
-            if (cost + 1 < costs_.at(current.second.x - 2, current.second.y)) {
-              costs_.at(current.second.x - 2, current.second.y) = cost + 1;
-              coming_from_.at(current.second.x - 2, current.second.y) =
-                  static_cast<int>(Direction::EAST);
-              queue.insert(
-                  {cost + 1,
-                   {current.second.x - 2, current.second.y, Direction::WEST}});
-            }
-          }
-        }
-        Location loc{current.second.x - 1, current.second.y, Direction::WEST};
-        if (cost < costs_.at(loc.x, loc.y)) {
-          costs_.at(loc.x, loc.y) = cost;
-          coming_from_.at(loc.x, loc.y) = static_cast<int>(Direction::EAST);
-          queue.insert({cost, loc});
-        }
+    };
+    {
+      std::vector<std::jthread> threads{};
+      for (unsigned int thread = 0; thread < num_threads; ++thread) {
+        const std::size_t from = std::min(thread * band, num_words);
+        const std::size_t to = std::min(from + band, num_words);
+        threads.emplace_back(mark, from, to);
       }
     }
-    return costs_.at(end_.x, end_.y);
+    return optimal_seating_spots;
   }
 
-  int get_path_length() { return path_length_; };
-  const array2D::Array2D<int> &get_costs() { return costs_; }
-  const array2D::Array2D<int> &get_coming_from() { return coming_from_; }
+private:
+  std::size_t state(std::size_t x, std::size_t y, Direction direction) const {
+    return to_underlying(direction) * cells_ + y * maze_.length() + x;
+  }
 
-  std::set<Location> get_optimal_seating_spots() {
-    std::set<Location> optimal_seating_spots{end_};
-    std::vector<Location> queue{end_};
-    std::set<Location> done {};
+  bool is_wall(std::size_t cell) const {
+    return maze_.get_tile_at(cell % maze_.length(), cell / maze_.length()) ==
+           Tile::Wall;
+  }
 
-    while (!queue.empty()) {
-      auto iter = --queue.end();
-      auto current = *iter;
-      queue.erase(iter);
+  const Location start_;
+  const Location end_;
+  const TileArray maze_;
+  const std::size_t cells_;
+  const std::array<std::ptrdiff_t, 4> steps_;
+  std::vector<int> costs_;
+  int path_length_;
+};
 
-      if(done.contains(current)){
-        continue;
+/**
+ * The maze with its corridors contracted. Nodes are the open cells that do
+ * not have exactly two open neighbours, i.e. junctions and dead ends, plus any
+ * cells that have to be kept. A corridor between two nodes becomes one edge
+ * per direction of travel, weighted with its steps and the turns along it.
+ * States are node * 4 + heading; turning in place stays implicit.
+ */
+class JunctionGraph {
+public:
+  struct Edge {
+    std::size_t from, to; // States
+    int weight;
+  };
+
+  JunctionGraph(const TileArray &maze, const std::vector<std::size_t> &keep)
+      : length_(maze.length()),
+        steps_{-static_cast<std::ptrdiff_t>(length_), 1,
+               static_cast<std::ptrdiff_t>(length_), -1},
+        open_(maze.length() * maze.height(), false),
+        node_of_cell_(open_.size(), kNO_NODE) {
+    for (std::size_t y = 0; y < maze.height(); ++y) {
+      for (std::size_t x = 0; x < maze.length(); ++x) {
+        open_[y * length_ + x] = maze.get_tile_at(x, y) != Tile::Wall;
       }
-      done.insert(current);
-      // North
-      std::size_t x = current.x;
-      std::size_t y = current.y - 1;
-      if (maze_.get_tile_at(x, y) != Tile::Wall) {
-        if (coming_from_.at(current.x, current.y) == coming_from_.at(x, y) &&
-            costs_.at(current.x, current.y) == costs_.at(x, y) + 1) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        } else if (coming_from_.at(current.x, current.y) !=
-                       coming_from_.at(x, y) &&
-                   costs_.at(current.x, current.y) == costs_.at(x, y) + 1001) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        }
-        x = current.x;
-        y = current.y - 2;
-        if (coming_from_.at(current.x, current.y) ==
-                static_cast<int>(Direction::NORTH) &&
-            coming_from_.at(x, y) == static_cast<int>(Direction::NORTH) &&
-            costs_.at(current.x, current.y) == costs_.at(x, y) + 2) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y + 1, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        }
+    }
+    for (std::size_t cell = 0; cell < open_.size(); ++cell) {
+      if (open_[cell] && (std::ranges::find(keep, cell) != keep.end() ||
+                          std::popcount(open_directions(cell)) != 2)) {
+        node_of_cell_[cell] = node_cells_.size();
+        node_cells_.push_back(cell);
       }
+    }
 
-      // East
-      x = current.x + 1;
-      y = current.y;
-      if (maze_.get_tile_at(x, y) != Tile::Wall) {
-        if (coming_from_.at(current.x, current.y) == coming_from_.at(x, y) &&
-            costs_.at(current.x, current.y) == costs_.at(x, y) + 1) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        } else if (coming_from_.at(current.x, current.y) !=
-                       coming_from_.at(x, y) &&
-                   costs_.at(current.x, current.y) == costs_.at(x, y) + 1001) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        }
-        x = current.x + 2;
-        y = current.y;
-        if (coming_from_.at(current.x, current.y) ==
-                static_cast<int>(Direction::EAST) &&
-            coming_from_.at(x, y) == static_cast<int>(Direction::EAST) &&
-            costs_.at(current.x, current.y) == costs_.at(x, y) + 2) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x - 1, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
+    for (std::size_t node = 0; node < node_cells_.size(); ++node) {
+      const unsigned int directions = open_directions(node_cells_[node]);
+      for (std::size_t heading = 0; heading < 4; ++heading) {
+        if (directions >> heading & 1) {
+          edges_.push_back(walk(node * 4 + heading, [](std::size_t) {}));
         }
       }
+    }
+    out_ = index_edges(&Edge::from, out_edges_);
+    in_ = index_edges(&Edge::to, in_edges_);
+  }
 
-      // South
-      x = current.x;
-      y = current.y + 1;
-      if (maze_.get_tile_at(x, y) != Tile::Wall) {
-        if (coming_from_.at(current.x, current.y) == coming_from_.at(x, y) &&
-            costs_.at(current.x, current.y) == costs_.at(x, y) + 1) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        } else if (coming_from_.at(current.x, current.y) !=
-                       coming_from_.at(x, y) &&
-                   costs_.at(current.x, current.y) == costs_.at(x, y) + 1001) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        }
-        x = current.x;
-        y = current.y + 2;
-        if (coming_from_.at(current.x, current.y) ==
-                static_cast<int>(Direction::SOUTH) &&
-            coming_from_.at(x, y) == static_cast<int>(Direction::SOUTH) &&
-            costs_.at(current.x, current.y) == costs_.at(x, y) + 2) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y - 1, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        }
+  static constexpr std::size_t kNO_NODE = SIZE_MAX;
+
+  std::size_t num_states() const { return 4 * node_cells_.size(); }
+  std::size_t node_at(std::size_t cell) const { return node_of_cell_[cell]; }
+  std::size_t cell_of(std::size_t node) const { return node_cells_[node]; }
+  const std::vector<Edge> &edges() const { return edges_; }
+
+  /**
+   * Costs of all states from the nearest source, or to the nearest source
+   * with reversed set.
+   */
+  std::vector<int> search(const std::vector<std::size_t> &sources,
+                          bool reversed) const {
+    const auto &offsets = reversed ? in_ : out_;
+    const auto &indices = reversed ? in_edges_ : out_edges_;
+    return dijkstra(num_states(), sources,
+                    [&](std::size_t current, auto relax) {
+                      const std::size_t node = current / 4;
+                      const std::size_t heading = current % 4;
+                      relax(node * 4 + (heading + 1) % 4, kTURN_COST);
+                      relax(node * 4 + (heading + 3) % 4, kTURN_COST);
+                      for (std::size_t i = offsets[current];
+                           i < offsets[current + 1]; ++i) {
+                        const Edge &edge = edges_[indices[i]];
+                        relax(reversed ? edge.from : edge.to, edge.weight);
+                      }
+                    });
+  }
+
+  /**
+   * Calls visit for every cell the edge passes, including both nodes.
+   */
+  template <typename Visit> void expand(const Edge &edge, Visit visit) const {
+    visit(node_cells_[edge.from / 4]);
+    walk(edge.from, visit);
+  }
+
+private:
+  unsigned int open_directions(std::size_t cell) const {
+    unsigned int directions = 0;
+    for (std::size_t heading = 0; heading < 4; ++heading) {
+      directions |= open_[cell + steps_[heading]] << heading;
+    }
+    return directions;
+  }
+
+  /**
+   * Follows the corridor leaving the node of state in its heading up to the
+   * next node, calling visit for every cell entered.
+   */
+  template <typename Visit> Edge walk(std::size_t state, Visit visit) const {
+    std::size_t cell = node_cells_[state / 4];
+    std::size_t heading = state % 4;
+    int weight = 0;
+    do {
+      cell += steps_[heading];
+      weight += kSTEP_COST;
+      visit(cell);
+      if (node_of_cell_[cell] != kNO_NODE) {
+        break;
+      }
+      if (!open_[cell + steps_[heading]]) {
+        heading = open_[cell + steps_[(heading + 1) % 4]] ? (heading + 1) % 4
+                                                          : (heading + 3) % 4;
+        weight += kTURN_COST;
       }
+    } while (true);
+    return {state, node_of_cell_[cell] * 4 + heading, weight};
+  }
 
-      // West
-      x = current.x - 1;
-      y = current.y;
-      if (maze_.get_tile_at(x, y) != Tile::Wall) {
-        if (coming_from_.at(current.x, current.y) == coming_from_.at(x, y) &&
-            costs_.at(current.x, current.y) == costs_.at(x, y) + 1) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        } else if (coming_from_.at(current.x, current.y) !=
-                       coming_from_.at(x, y) &&
-                   costs_.at(current.x, current.y) == costs_.at(x, y) + 1001) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        }
-        x = current.x - 2;
-        y = current.y;
-        if (coming_from_.at(current.x, current.y) ==
-                static_cast<int>(Direction::WEST) &&
-            coming_from_.at(x, y) == static_cast<int>(Direction::WEST) &&
-            costs_.at(current.x, current.y) == costs_.at(x, y) + 2) {
-          queue.push_back({x, y, Direction::NONE});
-          optimal_seating_spots.insert({x + 1, y, Direction::NONE});
-          optimal_seating_spots.insert({x, y, Direction::NONE});
-        }
+  /**
+   * Edge indices grouped by the state in member, as offsets into indices.
+   */
+  std::vector<std::size_t> index_edges(std::size_t Edge::*member,
+                                       std::vector<std::size_t> &indices) {
+    std::vector<std::size_t> offsets(num_states() + 1, 0);
+    for (const Edge &edge : edges_) {
+      ++offsets[edge.*member + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    indices.resize(edges_.size());
+    std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < edges_.size(); ++i) {
+      indices[next[edges_[i].*member]++] = i;
+    }
+    return offsets;
+  }
+
+  std::size_t length_;
+  std::array<std::ptrdiff_t, 4> steps_;
+  std::vector<bool> open_;
+  std::vector<std::size_t> node_of_cell_;
+  std::vector<std::size_t> node_cells_;
+  std::vector<Edge> edges_;
+  std::vector<std::size_t> out_, out_edges_;
+  std::vector<std::size_t> in_, in_edges_;
+};
+
+/**
+ * DijkstraPathing on the JunctionGraph of the maze. Start and end are kept as
+ * nodes, and seating spots are expanded from the tight edges back to cells.
+ */
+class JunctionPathing {
+public:
+  JunctionPathing(const TileArray &reindeer_maze, Location start, Location end)
+      : length_(reindeer_maze.length()), height_(reindeer_maze.height()),
+        start_(start.y * length_ + start.x), end_(end.y * length_ + end.x),
+        graph_(reindeer_maze, {start_, end_}) {
+    costs_ = graph_.search(
+        {graph_.node_at(start_) * 4 + to_underlying(start.direction)}, false);
+    path_length_ = kUNREACHED;
+    for (std::size_t heading = 0; heading < 4; ++heading) {
+      path_length_ =
+          std::min(path_length_, costs_[graph_.node_at(end_) * 4 + heading]);
+    }
+  }
+
+  int get_path_length() { return path_length_; };
+  std::size_t num_states() const { return graph_.num_states(); }
+
+  /**
+   * Same as DijkstraPathing::get_optimal_seating_spots. The contracted graph
+   * is small enough to mark on one thread, so num_threads is ignored.
+   */
+  TileSet
+  get_optimal_seating_spots([[maybe_unused]] unsigned int num_threads = 1) const {
+    std::vector<std::size_t> ends{};
+    for (std::size_t heading = 0; heading < 4; ++heading) {
+      ends.push_back(graph_.node_at(end_) * 4 + heading);
+    }
+    const std::vector<int> costs_to_end = graph_.search(ends, true);
+
+    TileSet optimal_seating_spots(length_, height_);
+    auto insert = [&](std::size_t cell) {
+      optimal_seating_spots.insert(cell % length_, cell / length_);
+    };
+    for (std::size_t state = 0; state < graph_.num_states(); ++state) {
+      if (costs_[state] != kUNREACHED && costs_to_end[state] != kUNREACHED &&
+          costs_[state] + costs_to_end[state] == path_length_) {
+        insert(graph_.cell_of(state / 4));
+      }
+    }
+    for (const auto &edge : graph_.edges()) {
+      if (costs_[edge.from] != kUNREACHED &&
+          costs_to_end[edge.to] != kUNREACHED &&
+          costs_[edge.from] + edge.weight + costs_to_end[edge.to] ==
+              path_length_) {
+        graph_.expand(edge, insert);
       }
     }
     return optimal_seating_spots;
   }
 
 private:
-  const Location start_;
-  const Location end_;
-  const TileArray maze_;
-  array2D::Array2D<int> costs_;
-  array2D::Array2D<int> coming_from_;
+  const std::size_t length_, height_;
+  const std::size_t start_, end_;
+  const JunctionGraph graph_;
+  std::vector<int> costs_;
   int path_length_;
 };
 
@@ -378,24 +572,40 @@ int main(int argc, char **argv) {
   TileArray reindeer_maze = read_reindeer_maze(argv[1]);
   std::size_t start_x = 1, start_y = reindeer_maze.height() - 2;
   std::size_t end_x = reindeer_maze.length() - 2, end_y = 1;
+  // Optional second argument is the number of threads marking seating spots
+  unsigned int num_threads =
+      argc > 2 ? std::max(1UL, std::stoul(argv[2])) : 1;
+
+  // Optional third argument "cells" searches the maze without contracting
+  // its corridors
+  const bool contract = argc <= 3 || std::string(argv[3]) != "cells";
 
-  // Task 1 : Score from Start to End
-  DijkstraPathing dijkstra_pathing =
-      DijkstraPathing(reindeer_maze, {start_x, start_y, Direction::EAST},
-                      {end_x, end_y, Direction::NONE});
-  int total_score = dijkstra_pathing.get_path_length();
-  std::cout << "Total score: " << total_score << "\n";
+  auto solve = [&](auto pathing) {
+    // Task 1 : Score from Start to End
+    int total_score = pathing.get_path_length();
+    std::cout << "Total score: " << total_score << "\n";
 
-  // Task 2 : Optimal seating spot
-  auto optimal_seating_spots = dijkstra_pathing.get_optimal_seating_spots();
-  std::cout << "Optimal seating spots: " << optimal_seating_spots.size()
-            << "\n";
+    // Task 2 : Optimal seating spot
+    auto optimal_seating_spots = pathing.get_optimal_seating_spots(num_threads);
+    std::cout << "Optimal seating spots: " << optimal_seating_spots.size()
+              << "\n";
+    return optimal_seating_spots;
+  };
+  const Location start{start_x, start_y, Direction::EAST};
+  const Location end{end_x, end_y, Direction::NONE};
+  const TileSet optimal_seating_spots =
+      contract ? solve(JunctionPathing(reindeer_maze, start, end))
+               : solve(DijkstraPathing(reindeer_maze, start, end));
 
   array2D::Array2D<char> visualize_seating_spots(reindeer_maze.length(),
                                                  reindeer_maze.height(), ' ');
-  std::ranges::for_each(optimal_seating_spots, [&](const auto &seating_spot) {
-    visualize_seating_spots.at(seating_spot.x, seating_spot.y) = '0';
-  });
+  for (std::size_t y = 0; y < reindeer_maze.height(); ++y) {
+    for (std::size_t x = 0; x < reindeer_maze.length(); ++x) {
+      if (optimal_seating_spots.contains(x, y)) {
+        visualize_seating_spots.at(x, y) = '0';
+      }
+    }
+  }
   std::function<std::string(char)> char_id = [](auto v) -> std::string {
     return std::string(1, v);
   };
@@ -410,25 +620,13 @@ int main(int argc, char **argv) {
   /*
   std::function<std::string(int)> func_int = [](int val) -> std::string {
     int width = 7;
-    if (val == INT_MAX - 2000) {
+    if (val == kUNREACHED) {
       return std::string(width, '#');
     }
     std::string ret = " " + std::to_string(val);
     return ret + std::string(width - ret.size(), ' ');
   };
-  array2D::print_array(dijkstra_pathing.get_costs(), func_int);
-  */
-  /*
-  std::function<std::string(int)> func_direction = [](int direction) ->
-  std::string { switch (direction) { case static_cast<int>(Direction::NONE):
-  return "#"; case static_cast<int>(Direction::NORTH): return "^"; case
-  static_cast<int>(Direction::EAST): return ">"; case
-  static_cast<int>(Direction::SOUTH): return "v"; case
-  static_cast<int>(Direction::WEST): return "<";
-    }
-    return "#";
-  };
-  array2D::print_array(dijkstra_pathing.get_coming_from(), func_direction);
+  array2D::print_array(DijkstraPathing(reindeer_maze, start, end).get_costs(),
+                       func_int);
   */
-  
-}
\ No newline at end of file
+}
@@ -1,15 +1,22 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <optional>
 #include <ostream>
+#include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 static const int kNUM_REGISTERS = 3;
@@ -163,6 +170,12 @@ public:
     output_.str(std::string());
   }
 
+  const std::vector<unsigned int> &get_program() const { return program_; }
+
+  const std::array<unsigned int, kNUM_REGISTERS> &get_registers() const {
+    return registers_;
+  }
+
   std::string get_output() const{
     auto str = output_.str();
     if(str.ends_with(",")){
@@ -214,6 +227,845 @@ std::ostream &operator<<(std::ostream &os,
   return os;
 }
 
+
+using Register = std::uint64_t;
+
+/**
+ * An opcode with its operand, decoded once so that the interpreter never
+ * touches the raw program. Opcodes that would read combo operand 7 are
+ * decoded to kINVALID, which throws only if it is executed.
+ */
+struct Instruction {
+  static constexpr std::uint8_t kINVALID = 8;
+  std::uint8_t opcode, operand;
+};
+
+/**
+ * Digits written by out. Interpreter::run stops and sets truncated when out
+ * is executed with kCAPACITY digits already written.
+ */
+struct Output {
+  static constexpr std::size_t kCAPACITY = 32;
+  std::array<std::uint8_t, kCAPACITY> digits;
+  std::size_t size = 0;
+  std::uint64_t instructions = 0;
+  bool truncated = false;
+
+  bool operator==(const Output &other) const {
+    return std::equal(digits.begin(), digits.begin() + size,
+                      other.digits.begin(), other.digits.begin() + other.size);
+  }
+};
+
+std::string to_string(const Output &output) {
+  std::string str{};
+  for (std::size_t i = 0; i < output.size; ++i) {
+    str += i == 0 ? "" : ",";
+    str += static_cast<char>('0' + output.digits[i]);
+  }
+  return str;
+}
+
+// a / 2^shift for any shift, including ones past the register width
+constexpr Register divide_by_power_of_two(Register a, Register shift) {
+  return shift < 64 ? a >> shift : 0;
+}
+
+/**
+ * Interpreter for the ChronospatialComputer on 64-bit registers. The register
+ * file holds the literals 0 to 3 in front of A, B and C, so a combo operand is
+ * a plain index into it.
+ */
+class Interpreter {
+public:
+  explicit Interpreter(const std::vector<unsigned int> &program)
+      : program_(program) {
+    // One instruction per position, since jnz may jump to odd positions
+    for (std::size_t ip = 0; ip + 1 < program.size(); ++ip) {
+      const unsigned int opcode = program[ip], operand = program[ip + 1];
+      if (opcode >= 8 || operand >= 8) {
+        throw std::invalid_argument("Program values have to be 3-bit.");
+      }
+      const bool reads_combo = opcode == 0 || opcode == 2 || opcode == 5 ||
+                               opcode == 6 || opcode == 7;
+      decoded_.push_back(
+          {reads_combo && operand == 7 ? Instruction::kINVALID
+                                       : static_cast<std::uint8_t>(opcode),
+           static_cast<std::uint8_t>(operand)});
+    }
+  }
+
+  Output run(Register a, Register b = 0, Register c = 0) const {
+    Output output{};
+    std::array<Register, 8> r{0, 1, 2, 3, a, b, c, 0};
+    const Instruction *code = decoded_.data();
+    const std::size_t end = decoded_.size();
+    std::size_t ip = 0;
+    std::uint64_t instructions = 0;
+
+    while (ip < end) {
+      const Instruction instruction = code[ip];
+      ip += 2;
+      ++instructions;
+      switch (instruction.opcode) {
+      case 0: // adv
+        r[4] = divide_by_power_of_two(r[4], r[instruction.operand]);
+        break;
+      case 1: // bxl
+        r[5] ^= instruction.operand;
+        break;
+      case 2: // bst
+        r[5] = r[instruction.operand] & 7;
+        break;
+      case 3: // jnz
+        if (r[4] != 0) {
+          ip = instruction.operand;
+        }
+        break;
+      case 4: // bxc
+        r[5] ^= r[6];
+        break;
+      case 5: // out
+        if (output.size == Output::kCAPACITY) {
+          output.truncated = true;
+          ip = end;
+          break;
+        }
+        output.digits[output.size++] = r[instruction.operand] & 7;
+        break;
+      case 6: // bdv
+        r[5] = divide_by_power_of_two(r[4], r[instruction.operand]);
+        break;
+      case 7: // cdv
+        r[6] = divide_by_power_of_two(r[4], r[instruction.operand]);
+        break;
+      default:
+        throw std::invalid_argument(
+            "Combo operand 7 should not appear in valid programs.");
+      }
+    }
+    output.instructions = instructions;
+    return output;
+  }
+
+  const std::vector<unsigned int> &get_program() const { return program_; }
+
+private:
+  std::vector<unsigned int> program_;
+  std::vector<Instruction> decoded_{};
+};
+
+std::string to_string_program(const std::vector<unsigned int> &program) {
+  std::string str{};
+  for (std::size_t i = 0; i < program.size(); ++i) {
+    str += (i == 0 ? "" : ",") + std::to_string(program[i]);
+  }
+  return str;
+}
+
+/**
+ * State of a compiled program: the register file of Interpreter and the
+ * output written so far.
+ */
+struct Machine {
+  std::array<Register, 8> r;
+  Output output;
+};
+
+using Step = void (*)(Machine &);
+
+/**
+ * One instruction with its opcode and operand fixed at compile time, so the
+ * combo operand is resolved to a literal or a register by the compiler.
+ */
+template <unsigned int Opcode, unsigned int Operand> void execute(Machine &m) {
+  if constexpr (Opcode == 0) {
+    m.r[4] = divide_by_power_of_two(m.r[4], m.r[Operand]);
+  } else if constexpr (Opcode == 1) {
+    m.r[5] ^= Operand;
+  } else if constexpr (Opcode == 2) {
+    m.r[5] = m.r[Operand] & 7;
+  } else if constexpr (Opcode == 4) {
+    m.r[5] ^= m.r[6];
+  } else if constexpr (Opcode == 5) {
+    if (m.output.size < Output::kCAPACITY) {
+      m.output.digits[m.output.size++] = m.r[Operand] & 7;
+    }
+  } else if constexpr (Opcode == 6) {
+    m.r[5] = divide_by_power_of_two(m.r[4], m.r[Operand]);
+  } else if constexpr (Opcode == 7) {
+    m.r[6] = divide_by_power_of_two(m.r[4], m.r[Operand]);
+  }
+}
+
+// All 64 instantiations of execute, indexed by opcode * 8 + operand
+template <std::size_t... I>
+constexpr std::array<Step, sizeof...(I)> make_steps(std::index_sequence<I...>) {
+  return {execute<I / 8, I % 8>...};
+}
+constexpr std::array<Step, 64> kSTEPS =
+    make_steps(std::make_index_sequence<64>{});
+
+// Runs N steps without a loop over them
+template <std::size_t N> void run_unrolled(const Step *steps, Machine &m) {
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    (steps[I](m), ...);
+  }(std::make_index_sequence<N>{});
+}
+
+using Runner = void (*)(const Step *, Machine &);
+
+template <std::size_t... N>
+constexpr std::array<Runner, sizeof...(N)>
+make_runners(std::index_sequence<N...>) {
+  return {run_unrolled<N>...};
+}
+constexpr std::size_t kMAX_UNROLLED = 16;
+constexpr std::array<Runner, kMAX_UNROLLED + 1> kRUNNERS =
+    make_runners(std::make_index_sequence<kMAX_UNROLLED + 1>{});
+
+/**
+ * True if the program has no jnz other than its last instruction, and that
+ * one jumps back to an even position before it. Such a program runs straight
+ * through its instructions and then repeats a fixed tail of them.
+ */
+bool has_single_loop_shape(const std::vector<unsigned int> &program) {
+  const std::size_t num_instructions = program.size() / 2;
+  for (std::size_t i = 0; i + 1 < num_instructions; ++i) {
+    if (program[2 * i] == 3) {
+      return false;
+    }
+  }
+  if (num_instructions == 0 || program[2 * num_instructions - 2] != 3) {
+    return true;
+  }
+  const std::size_t target = program[2 * num_instructions - 1];
+  return target % 2 == 0 && target / 2 + 1 < num_instructions;
+}
+
+/**
+ * A program compiled into a chain of specialised steps. Only programs whose
+ * single jnz is their last instruction can be compiled: everything before the
+ * jump target runs once, and the loop body from the target up to the jnz is
+ * unrolled (up to kMAX_UNROLLED steps) and repeated while A is not zero.
+ * Unlike Interpreter::run, instructions are not counted.
+ */
+class CompiledProgram {
+public:
+  static std::optional<CompiledProgram>
+  compile(const std::vector<unsigned int> &program) {
+    if (!has_single_loop_shape(program)) {
+      return std::nullopt;
+    }
+    const std::size_t num_instructions = program.size() / 2;
+    std::vector<Step> steps{};
+    for (std::size_t i = 0; i < num_instructions; ++i) {
+      const unsigned int opcode = program[2 * i], operand = program[2 * i + 1];
+      if (opcode >= 8 || operand >= 8) {
+        throw std::invalid_argument("Program values have to be 3-bit.");
+      }
+      if (opcode == 3) {
+        continue;
+      }
+      if (operand == 7 && opcode != 1 && opcode != 4) {
+        throw std::invalid_argument(
+            "Combo operand 7 should not appear in valid programs.");
+      }
+      steps.push_back(kSTEPS[8 * opcode + operand]);
+    }
+
+    if (num_instructions == 0 || program[2 * num_instructions - 2] != 3) {
+      return CompiledProgram{steps, {}, false};
+    }
+    const std::size_t target = program[2 * num_instructions - 1] / 2;
+    return CompiledProgram{{steps.begin(), steps.begin() + target},
+                           {steps.begin() + target, steps.end()}, true};
+  }
+
+  Output run(Register a, Register b = 0, Register c = 0) const {
+    Machine m{{0, 1, 2, 3, a, b, c, 0}, {}};
+    for (Step step : prologue_) {
+      step(m);
+    }
+    if (!loops_) {
+      return m.output;
+    }
+    do {
+      if (loop_.size() <= kMAX_UNROLLED) {
+        kRUNNERS[loop_.size()](loop_.data(), m);
+      } else {
+        for (Step step : loop_) {
+          step(m);
+        }
+      }
+    } while (m.r[4] != 0 && m.output.size < Output::kCAPACITY);
+    return m.output;
+  }
+
+private:
+  CompiledProgram(std::vector<Step> prologue, std::vector<Step> loop,
+                  bool loops)
+      : prologue_(std::move(prologue)), loop_(std::move(loop)),
+        loops_(loops) {}
+
+  std::vector<Step> prologue_;
+  std::vector<Step> loop_;
+  bool loops_;
+};
+
+/**
+ * One line per instruction with its combo operand resolved to a literal or a
+ * register, followed by what the instruction does.
+ */
+std::string disassemble(const std::vector<unsigned int> &program) {
+  static const std::array<std::string, 8> kMNEMONICS{
+      "adv", "bxl", "bst", "jnz", "bxc", "out", "bdv", "cdv"};
+  static const std::array<std::string, 8> kCOMBO{"0", "1", "2", "3",
+                                                 "A", "B", "C", "invalid"};
+  std::ostringstream disassembly{};
+  for (std::size_t ip = 0; ip + 1 < program.size(); ip += 2) {
+    const unsigned int opcode = program[ip] % 8, operand = program[ip + 1];
+    const std::string literal = std::to_string(operand);
+    const std::string combo = kCOMBO[operand % 8];
+    const std::array<std::string, 8> operands{combo, literal, combo, literal,
+                                              "",    combo,   combo, combo};
+    const std::array<std::string, 8> effects{
+        "A = A >> " + combo,
+        "B = B ^ " + literal,
+        "B = " + combo + " & 7",
+        "if A != 0 jump to " + literal,
+        "B = B ^ C",
+        "output " + combo + " & 7",
+        "B = A >> " + combo,
+        "C = A >> " + combo};
+    disassembly << std::setw(3) << ip << ": " << std::left << std::setw(12)
+                << kMNEMONICS[opcode] + " " + operands[opcode] << std::right
+                << "; " << effects[opcode] << "\n";
+  }
+  return disassembly.str();
+}
+
+/**
+ * The output of one loop iteration as a function of the low bits of A at its
+ * start. It can be derived for programs of single loop shape that jump back
+ * to 0, shift A right by exactly 3 once and output once per iteration, and
+ * write B and C before reading them. A program like that outputs digit i
+ * from A >> 3 * i and runs as many iterations as A has octal digits, so it can
+ * be evaluated without interpreting it.
+ */
+class OutputModel {
+public:
+  static constexpr std::size_t kMAX_BITS = 16;
+
+  static std::optional<OutputModel>
+  derive(const std::vector<unsigned int> &program) {
+    const std::size_t num_instructions = program.size() / 2;
+    if (num_instructions < 2 || !has_single_loop_shape(program) ||
+        program[2 * num_instructions - 2] != 3 ||
+        program[2 * num_instructions - 1] != 0) {
+      return std::nullopt;
+    }
+
+    // Symbolic value of a register. For values that are not small (< 8) only
+    // the low three bits are known to depend on the low bits of A.
+    struct Value {
+      bool defined, small;
+      std::size_t bits;
+      std::string expression;
+    };
+    std::size_t shift = 0, num_shifts = 0, num_outputs = 0;
+    Value b{false, false, 0, ""}, c{false, false, 0, ""}, output{};
+    auto a = [&] {
+      return Value{true, false, shift + 3,
+                   shift == 0 ? "a" : "(a >> " + std::to_string(shift) + ")"};
+    };
+    auto combo = [&](unsigned int operand) -> std::optional<Value> {
+      if (operand < 4) {
+        return Value{true, true, 0, std::to_string(operand)};
+      }
+      const Value value = operand == 4 ? a() : operand == 5 ? b : c;
+      if (operand == 7 || !value.defined) {
+        return std::nullopt;
+      }
+      return value;
+    };
+
+    for (std::size_t i = 0; i + 1 < num_instructions; ++i) {
+      const unsigned int opcode = program[2 * i], operand = program[2 * i + 1];
+      const auto value = combo(operand);
+      switch (opcode) {
+      case 0: // adv
+        if (operand != 3 || num_shifts++ > 0) {
+          return std::nullopt;
+        }
+        shift += 3;
+        break;
+      case 1: // bxl
+        if (!b.defined) {
+          return std::nullopt;
+        }
+        b = {true, b.small, b.bits,
+             "(" + b.expression + " ^ " + std::to_string(operand) + ")"};
+        break;
+      case 2: // bst
+        if (!value) {
+          return std::nullopt;
+        }
+        b = {true, true, value->bits,
+             value->small ? value->expression
+                          : "(" + value->expression + " & 7)"};
+        break;
+      case 4: // bxc
+        if (!b.defined || !c.defined) {
+          return std::nullopt;
+        }
+        b = {true, b.small && c.small, std::max(b.bits, c.bits),
+             "(" + b.expression + " ^ " + c.expression + ")"};
+        break;
+      case 5: // out
+        if (!value || num_outputs++ > 0) {
+          return std::nullopt;
+        }
+        output = *value;
+        break;
+      case 6: // bdv
+      case 7: { // cdv
+        if (!value || !value->small) {
+          return std::nullopt;
+        }
+        const Value shifted{
+            true, false,
+            std::max<std::size_t>(a().bits + (operand < 4 ? operand : 7),
+                                  value->bits),
+            "(" + a().expression + " >> " + value->expression + ")"};
+        (opcode == 6 ? b : c) = shifted;
+        break;
+      }
+      }
+    }
+    if (num_shifts != 1 || num_outputs != 1 || output.bits > kMAX_BITS) {
+      return std::nullopt;
+    }
+
+    // Tabulate the loop body on its own for every value of the low bits
+    const Interpreter body{std::vector<unsigned int>(
+        program.begin(), program.begin() + 2 * num_instructions - 2)};
+    std::vector<std::uint8_t> table(std::size_t{1} << output.bits);
+    for (std::size_t low_bits = 0; low_bits < table.size(); ++low_bits) {
+      table[low_bits] = body.run(low_bits).digits[0];
+    }
+    return OutputModel{std::move(table), output.bits,
+                       output.small ? output.expression
+                                    : output.expression + " & 7"};
+  }
+
+  std::uint8_t digit(Register a) const { return table_[a & mask_]; }
+
+  Output run(Register a) const {
+    Output output{};
+    do {
+      output.digits[output.size++] = digit(a);
+      a >>= 3;
+    } while (a != 0);
+    return output;
+  }
+
+  std::size_t bits() const { return bits_; }
+  const std::string &expression() const { return expression_; }
+
+private:
+  OutputModel(std::vector<std::uint8_t> table, std::size_t bits,
+              std::string expression)
+      : table_(std::move(table)), bits_(bits), mask_((Register{1} << bits) - 1),
+        expression_(std::move(expression)) {}
+
+  std::vector<std::uint8_t> table_;
+  std::size_t bits_;
+  Register mask_;
+  std::string expression_;
+};
+
+/**
+ * Digits written by Lanes machines, stored digit-major so that one out writes
+ * Lanes consecutive bytes.
+ */
+template <std::size_t Lanes> struct BatchOutput {
+  std::array<std::array<std::uint8_t, Lanes>, Output::kCAPACITY> digits;
+  std::array<std::uint8_t, Lanes> sizes{};
+
+  Output lane(std::size_t lane) const {
+    Output output{};
+    output.size = sizes[lane];
+    for (std::size_t i = 0; i < output.size; ++i) {
+      output.digits[i] = digits[i][lane];
+    }
+    return output;
+  }
+};
+
+/**
+ * Runs a program for Lanes values of register A at once. Programs of single
+ * loop shape run in lockstep on one instruction pointer, and every instruction
+ * is a loop over the lanes that compilers vectorise (into AVX2 variable shifts
+ * with -mavx2). A lane whose A is zero at the jnz has halted; as the jnz is
+ * the last instruction it only stops counting its outputs. Programs of other
+ * shapes run lane by lane on the Interpreter.
+ */
+template <std::size_t Lanes> class BatchInterpreter {
+public:
+  using Lane = std::array<Register, Lanes>;
+
+  explicit BatchInterpreter(const std::vector<unsigned int> &program)
+      : interpreter_(program), lockstep_(has_single_loop_shape(program)) {
+    for (std::size_t ip = 0; ip + 1 < program.size(); ip += 2) {
+      const unsigned int opcode = program[ip], operand = program[ip + 1];
+      const bool reads_combo = opcode == 0 || opcode == 2 || opcode == 5 ||
+                               opcode == 6 || opcode == 7;
+      decoded_.push_back(
+          {reads_combo && operand == 7 ? Instruction::kINVALID
+                                       : static_cast<std::uint8_t>(opcode),
+           static_cast<std::uint8_t>(operand)});
+    }
+  }
+
+  BatchOutput<Lanes> run(const Lane &a, Register b = 0, Register c = 0) const {
+    BatchOutput<Lanes> output{};
+    if (!lockstep_) {
+      for (std::size_t lane = 0; lane < Lanes; ++lane) {
+        const Output single = interpreter_.run(a[lane], b, c);
+        output.sizes[lane] = single.size;
+        for (std::size_t i = 0; i < single.size; ++i) {
+          output.digits[i][lane] = single.digits[i];
+        }
+      }
+      return output;
+    }
+
+    std::array<Lane, 8> r{};
+    for (std::size_t literal = 0; literal < 4; ++literal) {
+      r[literal].fill(literal);
+    }
+    r[4] = a;
+    r[5].fill(b);
+    r[6].fill(c);
+    std::array<std::uint8_t, Lanes> active{};
+    active.fill(1);
+
+    const std::size_t end = decoded_.size();
+    std::size_t ip = 0, outputs = 0;
+    while (ip < end && outputs < Output::kCAPACITY) {
+      const Instruction instruction = decoded_[ip++];
+      const Lane &combo = r[instruction.operand];
+      switch (instruction.opcode) {
+      case 0: // adv
+        for (std::size_t lane = 0; lane < Lanes; ++lane) {
+          r[4][lane] = divide_by_power_of_two(r[4][lane], combo[lane]);
+        }
+        break;
+      case 1: // bxl
+        for (std::size_t lane = 0; lane < Lanes; ++lane) {
+          r[5][lane] ^= instruction.operand;
+        }
+        break;
+      case 2: // bst
+        for (std::size_t lane = 0; lane < Lanes; ++lane) {
+          r[5][lane] = combo[lane] & 7;
+        }
+        break;
+      case 3: { // jnz
+        std::uint8_t any_active = 0;
+        for (std::size_t lane = 0; lane < Lanes; ++lane) {
+          active[lane] &= r[4][lane] != 0;
+          any_active |= active[lane];
+        }
+        if (any_active) {
+          ip = instruction.operand / 2;
+        }
+        break;
+      }
+      case 4: // bxc
+        for (std::size_t lane = 0; lane < Lanes; ++lane) {
+          r[5][lane] ^= r[6][lane];
+        }
+        break;
+      case 5: // out
+        for (std::size_t lane = 0; lane < Lanes; ++lane) {
+          output.digits[outputs][lane] = combo[lane] & 7;
+          output.sizes[lane] += active[lane];
+        }
+        ++outputs;
+        break;
+      case 6: // bdv
+        for (std::size_t lane = 0; lane < Lanes; ++lane) {
+          r[5][lane] = divide_by_power_of_two(r[4][lane], combo[lane]);
+        }
+        break;
+      case 7: // cdv
+        for (std::size_t lane = 0; lane < Lanes; ++lane) {
+          r[6][lane] = divide_by_power_of_two(r[4][lane], combo[lane]);
+        }
+        break;
+      default:
+        throw std::invalid_argument(
+            "Combo operand 7 should not appear in valid programs.");
+      }
+    }
+    return output;
+  }
+
+private:
+  Interpreter interpreter_;
+  bool lockstep_;
+  std::vector<Instruction> decoded_{};
+};
+
+/**
+ * Compares CompiledProgram::run, BatchInterpreter::run and OutputModel::run
+ * with Interpreter::run on the programs of test_computer, the examples and
+ * the loaded program, for register values 0 to count - 1 and count
+ * pseudo-random ones. Returns the number of mismatches.
+ */
+std::size_t test_against_interpreter(const std::vector<unsigned int> &loaded,
+                                     std::size_t count) {
+  const std::vector<std::vector<unsigned int>> programs{
+      {2, 6},
+      {5, 0, 5, 1, 5, 4},
+      {0, 1, 5, 4, 3, 0},
+      {1, 7},
+      {4, 0},
+      {0, 3, 5, 4, 3, 0},
+      {2, 4, 1, 1, 7, 5, 1, 5, 4, 0, 0, 3, 5, 5, 3, 0},
+      {2, 4, 1, 3, 7, 5, 4, 1, 1, 3, 0, 3, 5, 5, 3, 0},
+      {2, 4, 1, 5, 7, 5, 1, 6, 0, 3, 4, 6, 5, 5, 3, 0},
+      {5, 4, 0, 1, 2, 4, 5, 5, 3, 2}, // Loops back past a prologue
+      {0, 1, 3, 6, 5, 4, 3, 0},       // Jumps from the middle
+      loaded};
+  constexpr std::size_t kLANES = 16;
+  std::mt19937_64 generator{17};
+  std::size_t mismatches = 0;
+  for (const auto &program : programs) {
+    const Interpreter interpreter{program};
+    const auto compiled = CompiledProgram::compile(program);
+    const BatchInterpreter<kLANES> batch{program};
+    const auto model = OutputModel::derive(program);
+    std::size_t program_mismatches = 0;
+    for (std::size_t i = 0; i < 2 * count; i += kLANES) {
+      typename BatchInterpreter<kLANES>::Lane a{};
+      for (std::size_t lane = 0; lane < kLANES; ++lane) {
+        a[lane] = i < count ? i + lane : generator();
+      }
+      const Register b = i < count ? 0 : generator() % 1024;
+      const Register c = i < count ? 0 : generator() % 1024;
+      const BatchOutput<kLANES> batch_output = batch.run(a, b, c);
+      for (std::size_t lane = 0; lane < kLANES; ++lane) {
+        const Output expected = interpreter.run(a[lane], b, c);
+        if (!(batch_output.lane(lane) == expected) ||
+            (compiled && !(compiled->run(a[lane], b, c) == expected)) ||
+            (model && !(model->run(a[lane]) == expected))) {
+          ++program_mismatches;
+        }
+      }
+    }
+    std::cout << to_string_program(program) << ": " << program_mismatches
+              << " mismatches" << (compiled ? "" : " (not compiled)")
+              << (model ? " (modelled)" : "") << "\n";
+    mismatches += program_mismatches;
+  }
+  return mismatches;
+}
+
+/**
+ * Smallest A for which the program outputs itself, for programs that shift A
+ * right by three bits per output and halt once A is zero. The output digit i
+ * then only depends on A >> 3 * i, so A is built from its most significant
+ * octal digit down. Every A that outputs the last k values of the program is
+ * extended by the eight possible next digits, and those that output the last
+ * k + 1 values are kept. With an OutputModel only the new first digit has to
+ * be checked. Otherwise the eight extensions of a candidate run as one
+ * BatchInterpreter batch, and the candidates of a level are split over
+ * num_threads threads.
+ */
+std::optional<Register> find_quine(const Interpreter &interpreter, Register b,
+                                   Register c, unsigned int num_threads = 1) {
+  const std::vector<unsigned int> &program = interpreter.get_program();
+  if (program.empty()) {
+    return std::nullopt;
+  }
+  // 22 octal digits are 66 bits, so the leading one has to be 0 or 1
+  if (program.size() > 22 || program.size() > Output::kCAPACITY) {
+    throw std::overflow_error(
+        "A quine for this program needs more than 64 bits in register A.");
+  }
+  // Extending a candidate by a digit must not shift bits out of register A
+  auto fits_another_digit = [](Register candidate) {
+    return candidate >> 61 == 0;
+  };
+
+  std::vector<Register> candidates{0};
+  if (const auto model = OutputModel::derive(program)) {
+    // Digits after the first come from a >> 3, the candidate extended
+    for (std::size_t from = program.size();
+         from-- > 0 && !candidates.empty();) {
+      std::vector<Register> extended{};
+      for (Register candidate : candidates) {
+        for (Register digit = 0; fits_another_digit(candidate) && digit < 8;
+             ++digit) {
+          const Register a = candidate << 3 | digit;
+          if (model->digit(a) == program[from] &&
+              (candidate != 0 || from + 1 == program.size())) {
+            extended.push_back(a);
+          }
+        }
+      }
+      candidates = std::move(extended);
+    }
+    return candidates.empty() ? std::nullopt
+                              : std::optional{std::ranges::min(candidates)};
+  }
+
+  const BatchInterpreter<8> batch{program};
+  for (std::size_t from = program.size(); from-- > 0;) {
+    std::vector<std::vector<Register>> per_thread(num_threads);
+    {
+      std::vector<std::jthread> threads{};
+      for (unsigned int thread = 0; thread < num_threads; ++thread) {
+        threads.emplace_back([&, thread] {
+          for (std::size_t i = thread; i < candidates.size();
+               i += num_threads) {
+            if (!fits_another_digit(candidates[i])) {
+              continue;
+            }
+            BatchInterpreter<8>::Lane a{};
+            for (std::size_t digit = 0; digit < 8; ++digit) {
+              a[digit] = candidates[i] << 3 | digit;
+            }
+            const BatchOutput<8> outputs = batch.run(a, b, c);
+            for (std::size_t digit = 0; digit < 8; ++digit) {
+              bool matches = outputs.sizes[digit] == program.size() - from;
+              for (std::size_t j = 0; matches && j < outputs.sizes[digit];
+                   ++j) {
+                matches = outputs.digits[j][digit] == program[from + j];
+              }
+              if (matches) {
+                per_thread[thread].push_back(a[digit]);
+              }
+            }
+          }
+        });
+      }
+    }
+    candidates.clear();
+    for (const auto &found : per_thread) {
+      candidates.insert(candidates.end(), found.begin(), found.end());
+    }
+    if (candidates.empty()) {
+      return std::nullopt;
+    }
+  }
+  return std::ranges::min(candidates);
+}
+
+/**
+ * Seconds BatchInterpreter<Lanes> takes for runs consecutive values of
+ * register A, rounded up to whole batches.
+ */
+template <std::size_t Lanes>
+double time_batches(const ChronospatialComputer &computer, std::size_t runs,
+                    std::uint64_t &checksum) {
+  const BatchInterpreter<Lanes> batch{computer.get_program()};
+  const auto registers = computer.get_registers();
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < runs; i += Lanes) {
+    typename BatchInterpreter<Lanes>::Lane a{};
+    for (std::size_t lane = 0; lane < Lanes; ++lane) {
+      a[lane] = registers[Registers::A] + i + lane;
+    }
+    const BatchOutput<Lanes> outputs =
+        batch.run(a, registers[Registers::B], registers[Registers::C]);
+    for (std::size_t lane = 0; lane < Lanes; ++lane) {
+      checksum += outputs.sizes[lane];
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+/**
+ * Runs both the interpreter and ChronospatialComputer::run on runs
+ * consecutive values of register A and reports instructions per second.
+ */
+void benchmark_interpreters(const ChronospatialComputer &computer,
+                            std::size_t runs) {
+  const Interpreter interpreter{computer.get_program()};
+  const auto registers = computer.get_registers();
+
+  std::uint64_t instructions = 0, checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < runs; ++i) {
+    const Output output =
+        interpreter.run(registers[Registers::A] + i, registers[Registers::B],
+                        registers[Registers::C]);
+    if (output.truncated) {
+      std::cout << "Output of A = " << registers[Registers::A] + i
+                << " exceeds " << Output::kCAPACITY
+                << " digits, so instruction counts would not match\n";
+      return;
+    }
+    instructions += output.instructions;
+    checksum += output.size;
+  }
+  auto end = std::chrono::steady_clock::now();
+  const double interpreter_s =
+      std::chrono::duration<double>(end - start).count();
+
+  ChronospatialComputer reference{computer.get_program(), registers};
+  start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < runs; ++i) {
+    reference.reset();
+    reference.load_registers(
+        {static_cast<unsigned int>(registers[Registers::A] + i),
+         registers[Registers::B], registers[Registers::C]});
+    reference.run();
+    checksum += reference.get_output().size();
+  }
+  end = std::chrono::steady_clock::now();
+  const double reference_s = std::chrono::duration<double>(end - start).count();
+
+  std::cout << runs << " runs, " << instructions << " instructions\n";
+  std::cout << "Interpreter: " << instructions / interpreter_s / 1e6
+            << " M instructions/s\n";
+  std::cout << "ChronospatialComputer::run: "
+            << instructions / reference_s / 1e6 << " M instructions/s"
+            << " (speedup " << reference_s / interpreter_s << ", checksum "
+            << checksum << ")\n";
+
+  for (const auto &[lanes, batch_s] :
+       {std::pair{8, time_batches<8>(computer, runs, checksum)},
+        std::pair{16, time_batches<16>(computer, runs, checksum)}}) {
+    std::cout << "BatchInterpreter<" << lanes
+              << ">: " << instructions / batch_s / 1e6
+              << " M instructions/s (speedup " << interpreter_s / batch_s
+              << " over the interpreter, checksum " << checksum << ")\n";
+  }
+
+  const auto compiled = CompiledProgram::compile(computer.get_program());
+  if (!compiled) {
+    return;
+  }
+  start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < runs; ++i) {
+    checksum += compiled
+                    ->run(registers[Registers::A] + i, registers[Registers::B],
+                          registers[Registers::C])
+                    .size;
+  }
+  end = std::chrono::steady_clock::now();
+  const double compiled_s = std::chrono::duration<double>(end - start).count();
+  std::cout << "CompiledProgram: " << instructions / compiled_s / 1e6
+            << " M instructions/s (speedup " << interpreter_s / compiled_s
+            << " over the interpreter, checksum " << checksum << ")\n";
+}
+
 void test_computer() {
   ChronospatialComputer computer{{2, 6}, {0, 0, 9}};
   computer.run();
@@ -287,15 +1139,66 @@ int main(int argc, char **argv) {
   ChronospatialComputer computer = read_input(argv[1]);
   std::cout << computer << "\n";
 
+  const Interpreter interpreter{computer.get_program()};
+  const auto registers = computer.get_registers();
+
+  std::cout << disassemble(computer.get_program());
+  const auto model = OutputModel::derive(computer.get_program());
+  if (model) {
+    std::cout << "Output per iteration from the low " << model->bits()
+              << " bits of a = A: " << model->expression() << "\n";
+  }
+
   // Task 1
-  computer.run();
-  std::cout << "Output from computer run: " << computer.get_output() << "\n";
+  const Output output =
+      model ? model->run(registers[Registers::A])
+            : interpreter.run(registers[Registers::A], registers[Registers::B],
+                              registers[Registers::C]);
+  if (output.truncated) {
+    // Too long for the fixed buffer, run it without a limit instead
+    ChronospatialComputer unlimited{computer.get_program(), registers};
+    unlimited.run();
+    std::cout << "Output from computer run: " << unlimited.get_output()
+              << "\n";
+  } else {
+    std::cout << "Output from computer run: " << to_string(output) << "\n";
+  }
+
+  // Optional arguments:
+  //   bench <runs>      compare the interpreter against
+  //                     ChronospatialComputer::run
+  //   threads <count>   number of threads verifying quine candidates
+  //   check <count>     compare CompiledProgram and BatchInterpreter against
+  //                     the interpreter on 2 * <count> register values per
+  //                     program
+  std::size_t bench_runs = 0, check_count = 0;
+  unsigned int num_threads = 1;
+  for (int arg = 2; arg + 1 < argc; arg += 2) {
+    const std::string option = argv[arg];
+    if (option == "bench") {
+      bench_runs = std::stoul(argv[arg + 1]);
+    } else if (option == "check") {
+      check_count = std::stoul(argv[arg + 1]);
+    } else if (option == "threads") {
+      num_threads = std::max(1UL, std::stoul(argv[arg + 1]));
+    }
+  }
 
   // Task 2
-  for(unsigned int i = 0; i < 100; ++i) {
-    computer.reset();
-    computer.load_registers({i, 0, 0});
-    computer.run();
-    std::cout << "Start " << i << ": " << computer.get_output() << "\n";
+  const auto quine = find_quine(interpreter, registers[Registers::B],
+                                registers[Registers::C], num_threads);
+  if (quine) {
+    std::cout << "Lowest register A for a quine: " << *quine << "\n";
+  } else {
+    std::cout << "No register A makes the program output itself\n";
   }
-}
\ No newline at end of file
+
+  if (bench_runs > 0) {
+    benchmark_interpreters(computer, bench_runs);
+  }
+
+  if (check_count > 0) {
+    std::cout << test_against_interpreter(computer.get_program(), check_count)
+              << " mismatches in total\n";
+  }
+}
@@ -1,8 +1,8 @@
 #include <algorithm>
+#include <climits>
 #include <cstddef>
 #include <fstream>
 #include <iostream>
-#include <ranges>
 #include <stdexcept>
 #include <vector>
 
@@ -29,43 +29,47 @@ std::vector<paths::Point> read_input(std::string file_location) {
   return coordinates;
 }
 
-int get_shortest_path(std::size_t width, std::size_t height, paths::Point from,
-                      paths::Point to, std::vector<paths::Point> obstacles,
-                      int num_obstacles) {
-  array2D::Array2D<int> memory{width, height, paths::Dijkstra::kAIR};
-  auto view = obstacles | std::views::take(num_obstacles);
-  std::ranges::for_each(view, [&](const auto &p) {
-    memory.at(p.x, p.y) = paths::Dijkstra::kWALL;
-  });
+/**
+ * Memory where every corrupted cell holds how many bytes have fallen once it is
+ * corrupted, i.e. its index in obstacles plus one, and every other cell holds
+ * kNEVER_CORRUPTED. After m bytes exactly the cells with values above m are
+ * passable.
+ */
+static const int kNEVER_CORRUPTED = INT_MAX;
 
-  paths::Dijkstra dijkstra{memory, from};
-  return dijkstra.get_shortest_path_length(to);
+array2D::Array2D<int>
+get_corruption_times(std::size_t width, std::size_t height,
+                     const std::vector<paths::Point> &obstacles) {
+  array2D::Array2D<int> corruption_times{width, height, kNEVER_CORRUPTED};
+  for (std::size_t i = obstacles.size(); i-- > 0;) {
+    corruption_times.at(obstacles[i].x, obstacles[i].y) = i + 1;
+  }
+  return corruption_times;
 }
 
-paths::Point get_first_disabling_byte(std::size_t width, std::size_t height,
-                                      paths::Point from, paths::Point to,
-                                      std::vector<paths::Point> obstacles) {
-  std::size_t l = 0;
-  std::size_t r = obstacles.size();
-  while (r - l > 2) { // End condition
-    std::size_t m = (l + r) / 2;
-    if (get_shortest_path(width, height, from, to, obstacles, m) < INT_MAX) {
-      l = m + 1;
-    } else {
-      r = m;
-    }
-    //std::cout << "l: " << l << "| r: " << r << "\n";
-  }
-  if (get_shortest_path(width, height, from, to, obstacles, l) == INT_MAX) {
-    return obstacles.at(l - 1);
-  } else if (get_shortest_path(width, height, from, to, obstacles, l + 1) ==
-             INT_MAX) {
-    return obstacles.at(l);
-  } else if (get_shortest_path(width, height, from, to, obstacles, l + 2) ==
-             INT_MAX) {
-    return obstacles.at(l + 1);
+int get_shortest_path(paths::GridSearch &search,
+                      const array2D::Array2D<int> &corruption_times,
+                      paths::Point from, paths::Point to, int num_obstacles) {
+  return search.get_shortest_path_length(corruption_times, from, to,
+                                         num_obstacles);
+}
+
+paths::Point
+get_first_disabling_byte(std::size_t width, std::size_t height,
+                         paths::Point from, paths::Point to,
+                         const std::vector<paths::Point> &obstacles) {
+  const array2D::Array2D<int> corruption_times =
+      get_corruption_times(width, height, obstacles);
+  paths::GridSearch search{width, height};
+
+  // The exit is cut off once as many bytes have fallen as the widest path
+  // through the corruption times is wide
+  const int width_of_widest_path =
+      search.get_widest_path_width(corruption_times, from, to);
+  if (width_of_widest_path == kNEVER_CORRUPTED) {
+    throw std::invalid_argument("No falling byte cuts off the exit.");
   }
-  return obstacles.at(l + 2);
+  return obstacles.at(width_of_widest_path - 1);
 }
 
 int main(int argc, char **argv) {
@@ -75,25 +79,6 @@ int main(int argc, char **argv) {
   }
 
   std::vector<paths::Point> byte_coordinates = read_input(argv[1]);
-  array2D::Array2D<int> memory{71, 71, paths::Dijkstra::kAIR};
-  auto view = byte_coordinates | std::views::take(1024);
-  std::ranges::for_each(view, [&](const auto &p) {
-    memory.at(p.x, p.y) = paths::Dijkstra::kWALL;
-  });
-  paths::Dijkstra dijkstra{memory, {0, 0}};
-
-  std::function<std::string(int)> func = [](int val) {
-    if (val == 2) {
-      return "O";
-    }
-    if (val == 1) {
-      return " ";
-    }
-    return "#";
-  };
-  // std::ranges::for_each(path, [&](const auto &p){memory.at(p.x, p.y) = 2;});
-  //array2D::print_array(memory, func);
-  //std::cout << "\n";
 
   const std::size_t width = 71; // 7
   const std::size_t height = 71; // 7
@@ -101,8 +86,11 @@ int main(int argc, char **argv) {
   paths::Point to {70, 70}; //{6, 6};
   const int num_obstacles = 1024; //12;
 
+  const array2D::Array2D<int> corruption_times =
+      get_corruption_times(width, height, byte_coordinates);
+  paths::GridSearch search{width, height};
   int shortest_path_length =
-      get_shortest_path(width, width, from, to, byte_coordinates, num_obstacles);
+      get_shortest_path(search, corruption_times, from, to, num_obstacles);
   std::cout << "Shortest path: " << shortest_path_length << "\n";
 
   paths::Point first_disabling_byte =
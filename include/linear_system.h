@@ -0,0 +1,66 @@
+#ifndef _LINEAR_SYSTEM_H_
+#define _LINEAR_SYSTEM_H_
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace linear {
+
+using Integer = long long;
+using Matrix = std::vector<std::vector<Integer>>;
+
+template <std::size_t N> using SquareMatrix = std::array<std::array<Integer, N>, N>;
+
+/**
+ * coefficients * x = constants, with one row of coefficients per equation and
+ * one column per unknown.
+ */
+struct System {
+  Matrix coefficients;
+  std::vector<Integer> constants;
+};
+
+/**
+ * Result of fraction-free Gauss-Jordan elimination. Every pivot row i reads
+ * determinant * x[pivot_columns[i]] + sum(augmented[i][f] * x[f]) =
+ * augmented[i].back() over the free columns f.
+ */
+struct Elimination {
+  Matrix augmented;
+  std::vector<std::size_t> pivot_columns;
+  Integer determinant;
+  bool consistent;
+};
+
+enum class Status : int { Unique, NoIntegerSolution, Singular };
+
+/**
+ * Bareiss elimination extended to Gauss-Jordan form. All divisions are exact,
+ * so entries stay integers, and they are bounded by minors of the input.
+ * Throws std::overflow_error if an entry does not fit into an Integer.
+ */
+Elimination eliminate(const System &);
+
+/**
+ * Non-negative integer solution with the smallest cost (sum of costs[j] *
+ * x[j]), or std::nullopt if there is none. Dependent systems are searched over
+ * their integer solution lattice, which requires every unknown to be bounded
+ * by a row with only non-negative coefficients.
+ */
+std::optional<std::vector<Integer>> solve_min_cost(const System &,
+                                                   const std::vector<Integer> &costs);
+
+/**
+ * Cramer's rule for small square systems, unrolled for N = 2 and N = 3.
+ * Writes the solution to x if it is integral.
+ */
+template <std::size_t N>
+Status solve_unique(const SquareMatrix<N> &coefficients,
+                    const std::array<Integer, N> &constants,
+                    std::array<Integer, N> &x);
+
+} // namespace linear
+
+#endif // _LINEAR_SYSTEM_H_
@@ -3,7 +3,10 @@
 
 #include "array2d.h"
 #include "vector.h"
+#include <climits>
 #include <cstddef>
+#include <utility>
+#include <vector>
 
 namespace paths {
 
@@ -45,6 +48,36 @@ private:
   bool is_wall_at(std::size_t x, std::size_t y);
 };
 
+/**
+ * Shortest paths on a grid of unit steps that can be rerun without
+ * reallocating. Costs are stamped with the search that wrote them, so starting
+ * a new search does not clear them. A cell is passable if its maze value is
+ * above the threshold of the search, which with threshold 0 matches the rule
+ * of Dijkstra. The widest path query reads maze values as widths instead.
+ */
+class GridSearch {
+public:
+  GridSearch(std::size_t width, std::size_t height);
+
+  int get_shortest_path_length(const array2D::Array2D<int> &maze, Point from,
+                               Point to, int threshold = 0);
+  int get_widest_path_width(const array2D::Array2D<int> &maze, Point from,
+                            Point to);
+  int get_cost(Point) const;
+
+  static const int kUNREACHABLE = INT_MAX;
+
+private:
+  std::size_t index(Point p) const { return p.y * width_ + p.x; }
+
+  const std::size_t width_;
+  const std::size_t height_;
+  std::vector<int> costs_;
+  std::vector<unsigned int> generations_;
+  unsigned int generation_ = 0;
+  std::vector<std::size_t> queue_;
+  std::vector<std::pair<int, std::size_t>> heap_;
+};
 
 } // namespace paths
 
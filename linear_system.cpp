@@ -0,0 +1,431 @@
+#include "linear_system.h"
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+using Integer = linear::Integer;
+using Wide = __int128;
+
+Integer narrow(Wide value) {
+  if (value > LLONG_MAX || value < LLONG_MIN) {
+    throw std::overflow_error("Linear system value does not fit into Integer!");
+  }
+  return static_cast<Integer>(value);
+}
+
+Wide checked_mul(Wide a, Wide b) {
+  Wide result;
+  if (__builtin_mul_overflow(a, b, &result)) {
+    throw std::overflow_error("Linear system product overflowed!");
+  }
+  return result;
+}
+
+Wide checked_add(Wide a, Wide b) {
+  Wide result;
+  if (__builtin_add_overflow(a, b, &result)) {
+    throw std::overflow_error("Linear system sum overflowed!");
+  }
+  return result;
+}
+
+Wide checked_sub(Wide a, Wide b) {
+  Wide result;
+  if (__builtin_sub_overflow(a, b, &result)) {
+    throw std::overflow_error("Linear system difference overflowed!");
+  }
+  return result;
+}
+
+Wide floor_div(Wide a, Wide b) {
+  Wide quotient = a / b;
+  if (a % b != 0 && ((a < 0) != (b < 0))) {
+    --quotient;
+  }
+  return quotient;
+}
+
+Wide ceil_div(Wide a, Wide b) { return -floor_div(-a, b); }
+
+Wide mod(Wide a, Wide modulus) {
+  Wide remainder = a % modulus;
+  return remainder < 0 ? remainder + modulus : remainder;
+}
+
+// Returns gcd(a, b) and x, y with a * x + b * y = gcd(a, b)
+Wide extended_gcd(Wide a, Wide b, Wide &x, Wide &y) {
+  Wide old_r = a, r = b, old_x = 1, next_x = 0, old_y = 0, next_y = 1;
+  while (r != 0) {
+    Wide quotient = old_r / r;
+    old_r = std::exchange(r, old_r - quotient * r);
+    old_x = std::exchange(next_x, old_x - quotient * next_x);
+    old_y = std::exchange(next_y, old_y - quotient * next_y);
+  }
+  x = old_x;
+  y = old_y;
+  return old_r;
+}
+
+// t = residue (mod modulus)
+struct Congruence {
+  Wide residue;
+  Wide modulus;
+};
+
+// Solves a * t = b (mod modulus)
+std::optional<Congruence> solve_congruence(Wide a, Wide b, Wide modulus) {
+  a = mod(a, modulus);
+  b = mod(b, modulus);
+  Wide x, y;
+  const Wide gcd = extended_gcd(a, modulus, x, y);
+  if (b % gcd != 0) {
+    return std::nullopt;
+  }
+  const Wide reduced = modulus / gcd;
+  return Congruence{mod(mod(x, reduced) * (b / gcd % reduced), reduced),
+                    reduced};
+}
+
+// Chinese remainder theorem for moduli that need not be coprime
+std::optional<Congruence> combine(const Congruence &first,
+                                  const Congruence &second) {
+  Wide p, q;
+  const Wide gcd = extended_gcd(first.modulus, second.modulus, p, q);
+  const Wide difference = second.residue - first.residue;
+  if (difference % gcd != 0) {
+    return std::nullopt;
+  }
+  const Wide reduced = second.modulus / gcd;
+  const Wide modulus = checked_mul(first.modulus, reduced);
+  const Wide steps = mod(checked_mul(mod(difference / gcd, reduced), p), reduced);
+  return Congruence{mod(checked_add(first.residue,
+                                    checked_mul(first.modulus, steps)),
+                        modulus),
+                    modulus};
+}
+
+template <std::size_t N>
+Wide determinant(const linear::SquareMatrix<N> &m) {
+  static_assert(N == 2 || N == 3, "Only 2x2 and 3x3 systems are unrolled");
+  if constexpr (N == 2) {
+    return checked_sub(checked_mul(m[0][0], m[1][1]),
+                       checked_mul(m[0][1], m[1][0]));
+  } else {
+    auto minor = [&](std::size_t col1, std::size_t col2) {
+      return checked_sub(checked_mul(m[1][col1], m[2][col2]),
+                         checked_mul(m[1][col2], m[2][col1]));
+    };
+    return checked_add(checked_sub(checked_mul(m[0][0], minor(1, 2)),
+                                   checked_mul(m[0][1], minor(0, 2))),
+                       checked_mul(m[0][2], minor(0, 1)));
+  }
+}
+
+template <std::size_t N>
+linear::Status solve_square(const linear::System &system,
+                            std::vector<Integer> &x) {
+  linear::SquareMatrix<N> coefficients{};
+  std::array<Integer, N> constants{};
+  for (std::size_t row = 0; row < N; ++row) {
+    std::ranges::copy(system.coefficients[row], coefficients[row].begin());
+    constants[row] = system.constants[row];
+  }
+  std::array<Integer, N> solution{};
+  auto status = linear::solve_unique<N>(coefficients, constants, solution);
+  x.assign(solution.begin(), solution.end());
+  return status;
+}
+
+/**
+ * Walks the non-negative integer solutions of an eliminated, consistent
+ * system. All free unknowns but the last are enumerated within their bounds.
+ * Along the last one the pivot unknowns are affine, so the integral ones form
+ * an arithmetic progression (a system of congruences modulo the determinant),
+ * non-negativity gives an interval and the linear cost is minimal at one of
+ * its ends.
+ */
+class LatticeSearch {
+public:
+  LatticeSearch(const linear::System &system,
+                const linear::Elimination &elimination,
+                const std::vector<Integer> &costs)
+      : unknowns_(costs.size()), costs_(costs),
+        pivot_columns_(elimination.pivot_columns),
+        determinant_(elimination.determinant), assignment_(costs.size(), 0) {
+    const std::size_t rank = pivot_columns_.size();
+    rows_.assign(elimination.augmented.begin(),
+                 elimination.augmented.begin() + rank);
+    if (determinant_ < 0) {
+      for (auto &row : rows_) {
+        std::ranges::for_each(row, [](auto &val) { val = -val; });
+      }
+      determinant_ = -determinant_;
+    }
+
+    std::vector<bool> is_pivot(unknowns_, false);
+    std::ranges::for_each(pivot_columns_,
+                          [&](const auto &col) { is_pivot[col] = true; });
+    for (std::size_t col = 0; col < unknowns_; ++col) {
+      if (!is_pivot[col]) {
+        free_columns_.push_back(col);
+        upper_bounds_.push_back(upper_bound(system, col));
+      }
+    }
+  }
+
+  std::optional<std::vector<Integer>> run() {
+    std::vector<Wide> constants{};
+    std::ranges::for_each(rows_,
+                          [&](const auto &row) { constants.push_back(row.back()); });
+    if (free_columns_.empty()) {
+      check(constants);
+    } else {
+      enumerate(0, constants);
+    }
+    if (!best_cost_) {
+      return std::nullopt;
+    }
+    return best_;
+  }
+
+private:
+  // Largest value of unknown col allowed by a row without negative coefficients
+  static Wide upper_bound(const linear::System &system, std::size_t col) {
+    std::optional<Wide> bound{};
+    for (std::size_t row = 0; row < system.coefficients.size(); ++row) {
+      const auto &coefficients = system.coefficients[row];
+      if (coefficients[col] <= 0 ||
+          std::ranges::any_of(coefficients, [](auto val) { return val < 0; })) {
+        continue;
+      }
+      Wide row_bound = floor_div(system.constants[row], coefficients[col]);
+      bound = bound ? std::min(*bound, row_bound) : row_bound;
+    }
+    if (!bound) {
+      throw std::invalid_argument(
+          "Unknown of a dependent system is unbounded, cannot search its "
+          "solutions!");
+    }
+    return *bound;
+  }
+
+  void enumerate(std::size_t free_idx, const std::vector<Wide> &constants) {
+    if (free_idx + 1 == free_columns_.size()) {
+      solve_last(constants);
+      return;
+    }
+    const std::size_t col = free_columns_[free_idx];
+    std::vector<Wide> reduced = constants;
+    for (Wide val = 0; val <= upper_bounds_[free_idx]; ++val) {
+      assignment_[col] = narrow(val);
+      enumerate(free_idx + 1, reduced);
+      for (std::size_t row = 0; row < rows_.size(); ++row) {
+        reduced[row] = checked_sub(reduced[row], rows_[row][col]);
+      }
+    }
+  }
+
+  void solve_last(const std::vector<Wide> &constants) {
+    const std::size_t col = free_columns_.back();
+    Wide lowest = 0, highest = upper_bounds_.back();
+    Congruence congruence{0, 1};
+    Wide slope = checked_mul(costs_[col], determinant_);
+    for (std::size_t row = 0; row < rows_.size(); ++row) {
+      // determinant * x_pivot = constants[row] - coefficient * t >= 0
+      const Wide coefficient = rows_[row][col];
+      if (coefficient > 0) {
+        highest = std::min(highest, floor_div(constants[row], coefficient));
+      } else if (coefficient < 0) {
+        lowest = std::max(lowest, ceil_div(constants[row], coefficient));
+      } else if (constants[row] < 0) {
+        return;
+      }
+
+      auto row_congruence =
+          solve_congruence(coefficient, constants[row], determinant_);
+      if (!row_congruence) {
+        return;
+      }
+      auto combined = combine(congruence, *row_congruence);
+      if (!combined) {
+        return;
+      }
+      congruence = *combined;
+      slope = checked_sub(
+          slope, checked_mul(costs_[pivot_columns_[row]], coefficient));
+    }
+
+    Wide t;
+    if (slope >= 0) {
+      t = lowest + mod(congruence.residue - lowest, congruence.modulus);
+    } else {
+      t = highest - mod(highest - congruence.residue, congruence.modulus);
+    }
+    if (t < lowest || t > highest) {
+      return;
+    }
+
+    assignment_[col] = narrow(t);
+    std::vector<Wide> reduced = constants;
+    for (std::size_t row = 0; row < rows_.size(); ++row) {
+      reduced[row] = checked_sub(reduced[row],
+                                 checked_mul(rows_[row][col], t));
+    }
+    check(reduced);
+  }
+
+  // Pivot unknowns for fixed free unknowns, kept if integral, >= 0 and cheaper
+  void check(const std::vector<Wide> &constants) {
+    for (std::size_t row = 0; row < rows_.size(); ++row) {
+      if (constants[row] < 0 || constants[row] % determinant_ != 0) {
+        return;
+      }
+      assignment_[pivot_columns_[row]] = narrow(constants[row] / determinant_);
+    }
+    Wide cost = 0;
+    for (std::size_t col = 0; col < unknowns_; ++col) {
+      cost = checked_add(cost, checked_mul(costs_[col], assignment_[col]));
+    }
+    if (!best_cost_ || cost < *best_cost_) {
+      best_cost_ = cost;
+      best_ = assignment_;
+    }
+  }
+
+  const std::size_t unknowns_;
+  const std::vector<Integer> &costs_;
+  const std::vector<std::size_t> pivot_columns_;
+  linear::Matrix rows_{};
+  Wide determinant_;
+  std::vector<std::size_t> free_columns_{};
+  std::vector<Wide> upper_bounds_{};
+
+  std::vector<Integer> assignment_;
+  std::optional<Wide> best_cost_{};
+  std::vector<Integer> best_{};
+};
+
+} // namespace
+
+linear::Elimination linear::eliminate(const System &system) {
+  const std::size_t rows = system.coefficients.size();
+  if (system.constants.size() != rows) {
+    throw std::invalid_argument("Every equation needs exactly one constant!");
+  }
+  const std::size_t unknowns = rows == 0 ? 0 : system.coefficients[0].size();
+
+  Matrix augmented{};
+  augmented.reserve(rows);
+  for (std::size_t row = 0; row < rows; ++row) {
+    if (system.coefficients[row].size() != unknowns) {
+      throw std::invalid_argument(
+          "All equations need the same number of unknowns!");
+    }
+    augmented.push_back(system.coefficients[row]);
+    augmented.back().push_back(system.constants[row]);
+  }
+
+  std::vector<std::size_t> pivot_columns{};
+  Integer previous_pivot = 1;
+  std::size_t row = 0;
+  for (std::size_t col = 0; col < unknowns && row < rows; ++col) {
+    auto pivot_row =
+        std::find_if(augmented.begin() + row, augmented.end(),
+                     [&](const auto &equation) { return equation[col] != 0; });
+    if (pivot_row == augmented.end()) {
+      continue;
+    }
+    std::swap(*pivot_row, augmented[row]);
+
+    const Integer pivot = augmented[row][col];
+    for (std::size_t other = 0; other < rows; ++other) {
+      if (other == row) {
+        continue;
+      }
+      const Integer factor = augmented[other][col];
+      for (std::size_t j = 0; j <= unknowns; ++j) {
+        Wide numerator = checked_sub(checked_mul(pivot, augmented[other][j]),
+                                     checked_mul(factor, augmented[row][j]));
+        if (numerator % previous_pivot != 0) {
+          throw std::logic_error("Bareiss division is not exact!");
+        }
+        augmented[other][j] = narrow(numerator / previous_pivot);
+      }
+    }
+    previous_pivot = pivot;
+    pivot_columns.push_back(col);
+    ++row;
+  }
+
+  bool consistent = std::all_of(
+      augmented.begin() + row, augmented.end(),
+      [](const auto &equation) { return equation.back() == 0; });
+  return {augmented, pivot_columns, previous_pivot, consistent};
+}
+
+std::optional<std::vector<linear::Integer>>
+linear::solve_min_cost(const System &system, const std::vector<Integer> &costs) {
+  const std::size_t rows = system.coefficients.size();
+  const std::size_t unknowns = rows == 0 ? 0 : system.coefficients[0].size();
+  if (costs.size() != unknowns) {
+    throw std::invalid_argument("Every unknown needs exactly one cost!");
+  }
+
+  if (rows == unknowns && (rows == 2 || rows == 3) &&
+      system.constants.size() == rows) {
+    std::vector<Integer> x{};
+    Status status =
+        rows == 2 ? solve_square<2>(system, x) : solve_square<3>(system, x);
+    if (status == Status::NoIntegerSolution ||
+        (status == Status::Unique &&
+         std::ranges::any_of(x, [](auto val) { return val < 0; }))) {
+      return std::nullopt;
+    }
+    if (status == Status::Unique) {
+      return x;
+    }
+  }
+
+  Elimination elimination = eliminate(system);
+  if (!elimination.consistent) {
+    return std::nullopt;
+  }
+  return LatticeSearch(system, elimination, costs).run();
+}
+
+template <std::size_t N>
+linear::Status linear::solve_unique(const SquareMatrix<N> &coefficients,
+                                    const std::array<Integer, N> &constants,
+                                    std::array<Integer, N> &x) {
+  const Wide denominator = determinant<N>(coefficients);
+  if (denominator == 0) {
+    return Status::Singular;
+  }
+  std::array<Wide, N> numerators{};
+  for (std::size_t col = 0; col < N; ++col) {
+    SquareMatrix<N> replaced = coefficients;
+    for (std::size_t row = 0; row < N; ++row) {
+      replaced[row][col] = constants[row];
+    }
+    numerators[col] = determinant<N>(replaced);
+    if (numerators[col] % denominator != 0) {
+      return Status::NoIntegerSolution;
+    }
+  }
+  for (std::size_t col = 0; col < N; ++col) {
+    x[col] = narrow(numerators[col] / denominator);
+  }
+  return Status::Unique;
+}
+
+// Explicit instantiation
+template linear::Status linear::solve_unique<2>(const SquareMatrix<2> &,
+                                                const std::array<Integer, 2> &,
+                                                std::array<Integer, 2> &);
+template linear::Status linear::solve_unique<3>(const SquareMatrix<3> &,
+                                                const std::array<Integer, 3> &,
+                                                std::array<Integer, 3> &);
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <climits>
 #include <map>
+#include <stdexcept>
 
 enum class Direction : int {
   NORTH = 0,
@@ -89,3 +90,133 @@ bool paths::Dijkstra::is_wall_at(std::size_t x, std::size_t y) {
 int paths::Dijkstra::get_shortest_path_length(Point to) const{
   return costs_.cat(to.x, to.y);
 }
+
+paths::GridSearch::GridSearch(std::size_t width, std::size_t height)
+    : width_(width), height_(height), costs_(width * height, kUNREACHABLE),
+      generations_(width * height, 0), queue_(width * height) {}
+
+/**
+ * Breadth-first search from `from` that stops once `to` is reached. Returns
+ * kUNREACHABLE if `to` cannot be reached.
+ */
+int paths::GridSearch::get_shortest_path_length(
+    const array2D::Array2D<int> &maze, Point from, Point to, int threshold) {
+  if (maze.length() != width_ || maze.height() != height_) {
+    throw std::invalid_argument("Maze does not match the size of the search.");
+  }
+  if (++generation_ == 0) { // Stamps wrapped around
+    std::ranges::fill(generations_, 0);
+    generation_ = 1;
+  }
+  if (maze.cat(from.x, from.y) <= threshold) {
+    return kUNREACHABLE;
+  }
+
+  std::size_t head = 0, tail = 0;
+  auto visit = [&](std::size_t cell, int cost) {
+    generations_[cell] = generation_;
+    costs_[cell] = cost;
+    queue_[tail++] = cell;
+  };
+  visit(index(from), 0);
+  const std::size_t target = index(to);
+
+  while (head < tail) {
+    const std::size_t current = queue_[head++];
+    const int cost = costs_[current];
+    if (current == target) {
+      return cost;
+    }
+    const std::size_t x = current % width_, y = current / width_;
+    auto relax = [&](std::size_t neighbor) {
+      if (generations_[neighbor] != generation_ &&
+          maze.cat(neighbor % width_, neighbor / width_) > threshold) {
+        visit(neighbor, cost + 1);
+      }
+    };
+    if (x > 0) { // Left
+      relax(current - 1);
+    }
+    if (x + 1 < width_) { // Right
+      relax(current + 1);
+    }
+    if (y > 0) { // Up
+      relax(current - width_);
+    }
+    if (y + 1 < height_) { // Down
+      relax(current + width_);
+    }
+  }
+  return kUNREACHABLE;
+}
+
+/**
+ * Largest width w such that a path from `from` to `to` only passes cells with
+ * maze values of at least w, found by a Dijkstra that maximises the smallest
+ * value on the path. Searching the same maze for a shortest path with
+ * threshold t succeeds exactly when t is below this width. The widths of the
+ * search are available through get_cost.
+ */
+int paths::GridSearch::get_widest_path_width(const array2D::Array2D<int> &maze,
+                                             Point from, Point to) {
+  if (maze.length() != width_ || maze.height() != height_) {
+    throw std::invalid_argument("Maze does not match the size of the search.");
+  }
+  if (++generation_ == 0) { // Stamps wrapped around
+    std::ranges::fill(generations_, 0);
+    generation_ = 1;
+  }
+
+  heap_.clear();
+  auto visit = [&](std::size_t cell, int width) {
+    generations_[cell] = generation_;
+    costs_[cell] = width;
+    heap_.push_back({width, cell});
+    std::ranges::push_heap(heap_);
+  };
+  visit(index(from), maze.cat(from.x, from.y));
+  const std::size_t target = index(to);
+
+  while (!heap_.empty()) {
+    std::ranges::pop_heap(heap_);
+    const auto [width, current] = heap_.back();
+    heap_.pop_back();
+    if (width != costs_[current]) {
+      continue; // Stale entry
+    }
+    if (current == target) {
+      return width;
+    }
+    const std::size_t x = current % width_, y = current / width_;
+    auto relax = [&](std::size_t neighbor) {
+      const int neighbor_width = std::min(
+          width, maze.cat(neighbor % width_, neighbor / width_));
+      if (generations_[neighbor] != generation_ ||
+          neighbor_width > costs_[neighbor]) {
+        visit(neighbor, neighbor_width);
+      }
+    };
+    if (x > 0) { // Left
+      relax(current - 1);
+    }
+    if (x + 1 < width_) { // Right
+      relax(current + 1);
+    }
+    if (y > 0) { // Up
+      relax(current - width_);
+    }
+    if (y + 1 < height_) { // Down
+      relax(current + width_);
+    }
+  }
+  return costs_[target];
+}
+
+/**
+ * Cost found by the last search, which is complete up to the cost of its
+ * target.
+ */
+int paths::GridSearch::get_cost(Point p) const {
+  return generations_[index(p)] == generation_ ? costs_[index(p)]
+                                               : kUNREACHABLE;
+}